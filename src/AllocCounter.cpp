@@ -0,0 +1,110 @@
+/*
+ * AllocCounter.cpp
+ *
+ * Description: Counts the heap allocations of the process.
+ *              In the diagnostic build ("make ALLOC_STATS=1", which
+ *              defines HUFF_ALLOC_STATS), the global operator new is
+ *              replaced by one that counts every allocation and its
+ *              size. Otherwise nothing is replaced and the counts stay 0.
+ *
+ *
+ */
+
+#include "AllocCounter.h"
+
+#ifdef HUFF_ALLOC_STATS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// Totals of all threads since the program started.
+static atomic<unsigned long long> numOfAllocationsSoFar(0);
+static atomic<unsigned long long> allocatedBytesSoFar(0);
+
+// Desc: Count one allocation of "size" bytes and allocate it.
+// Post: Return NULL if there is not enough memory.
+static void *countedAlloc(size_t size) {
+	numOfAllocationsSoFar.fetch_add(1, memory_order_relaxed);
+	allocatedBytesSoFar.fetch_add(size, memory_order_relaxed);
+	return malloc(size == 0 ? 1 : size);
+} // countedAlloc
+
+// Replacements of the global allocation functions.
+// The aligned variants are left to the library; they use their own
+// allocation and deallocation pair.
+void *operator new(size_t size) {
+	void *ptr = countedAlloc(size);
+	if (ptr == NULL)
+		throw bad_alloc();
+	return ptr;
+}
+
+void *operator new[](size_t size) {
+	void *ptr = countedAlloc(size);
+	if (ptr == NULL)
+		throw bad_alloc();
+	return ptr;
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+	return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept {
+	return countedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, const nothrow_t &) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, const nothrow_t &) noexcept {
+	free(ptr);
+}
+
+// Desc: Return true if allocations are being counted.
+bool isAllocationCounted() {
+	return true;
+} // isAllocationCounted
+
+// Desc: Read the number of allocations and the bytes allocated so far.
+void readAllocations(unsigned long long &numOfAllocations, unsigned long long &allocatedBytes) {
+	numOfAllocations = numOfAllocationsSoFar.load(memory_order_relaxed);
+	allocatedBytes = allocatedBytesSoFar.load(memory_order_relaxed);
+} // readAllocations
+
+#else
+
+// Desc: Return true if allocations are being counted.
+bool isAllocationCounted() {
+	return false;
+} // isAllocationCounted
+
+// Desc: Read the number of allocations and the bytes allocated so far.
+void readAllocations(unsigned long long &numOfAllocations, unsigned long long &allocatedBytes) {
+	numOfAllocations = 0;
+	allocatedBytes = 0;
+} // readAllocations
+
+#endif
+
+// End of AllocCounter.cpp
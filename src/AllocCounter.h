@@ -0,0 +1,24 @@
+/*
+ * AllocCounter.h
+ *
+ * Description: Counts the heap allocations of the process.
+ *              In the diagnostic build ("make ALLOC_STATS=1", which
+ *              defines HUFF_ALLOC_STATS), the global operator new is
+ *              replaced by one that counts every allocation and its
+ *              size. Otherwise nothing is replaced and the counts stay 0.
+ *
+ *
+ */
+
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+// Desc: Return true if allocations are being counted.
+bool isAllocationCounted();
+
+// Desc: Read the number of allocations and the bytes allocated so far.
+void readAllocations(unsigned long long &numOfAllocations, unsigned long long &allocatedBytes);
+
+#endif
+
+// End of AllocCounter.h
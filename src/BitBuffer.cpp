@@ -0,0 +1,102 @@
+/*
+ * BitBuffer.cpp
+ *
+ * Description: It packs Huffman codes into a memory buffer.
+ *              Bits are written from the most significant bit of each
+ *              byte, the same order as OutBitStream::loadNextByte().
+ *
+ *
+ */
+
+#include <cstddef>
+#include "BitBuffer.h"
+
+// Desc: Constructor
+//       The table is built from the code tables of one Huffman tree.
+PairCodeTable::PairCodeTable(const unsigned *codeTable, const unsigned *codeLengthTable) {
+	entries = new Entry[NUM_OF_PAIRS];
+	for (unsigned first = 0; first < 256; first++) {
+		unsigned firstIndex = (char)first + 128;
+		for (unsigned second = 0; second < 256; second++) {
+			unsigned secondIndex = (char)second + 128;
+			Entry &entry = entries[(first << 8) | second];
+			unsigned length = codeLengthTable[firstIndex] + codeLengthTable[secondIndex];
+			if (length > MAX_PAIR_CODE_LENGTH || codeLengthTable[firstIndex] == 0 || codeLengthTable[secondIndex] == 0) {
+				entry.code = 0;
+				entry.length = 0;
+			} else {
+				entry.code = (codeTable[firstIndex] << codeLengthTable[secondIndex]) | codeTable[secondIndex];
+				entry.length = length;
+			}
+		}
+	}
+} // Constructor
+
+// Desc: Destructor
+PairCodeTable::~PairCodeTable() {
+	delete [] entries;
+} // Destructor
+
+
+// Desc: Constructor
+BitBuffer::BitBuffer() {
+	data = NULL;
+	length = 0;
+	bits = 0;
+	numOfBits = 0;
+} // Constructor
+
+// Desc: Set the destination of the following complete bytes.
+// Post: The length is reset to 0. Pending bits are kept, so that
+//       a code stream can be continued across several buffers.
+void BitBuffer::setDestination(char *data) {
+	this -> data = data;
+	length = 0;
+} // setDestination
+
+// Desc: Encode "size" characters using the code tables. If "pairs"
+//       is not NULL, two characters are encoded per lookup wherever
+//       the pair is in the table. The result is the same.
+//  Pre: The destination has room for 4 * size bytes.
+void BitBuffer::encode(const char *src, unsigned size, const unsigned *codeTable, const unsigned *codeLengthTable, 
+	const PairCodeTable *pairs) {
+	unsigned i = 0;
+	if (pairs != NULL) {
+		for (; i + 1 < size; i += 2) {
+			const PairCodeTable::Entry &entry = pairs -> getEntry(PairCodeTable::getPair(src[i], src[i + 1]));
+			if (entry.length != 0) {
+				writeCode(entry.code, entry.length);
+			} else {
+				writeCode(codeTable[src[i] + 128], codeLengthTable[src[i] + 128]);
+				writeCode(codeTable[src[i + 1] + 128], codeLengthTable[src[i + 1] + 128]);
+			}
+		}
+	}
+	for (; i < size; i++) {
+		writeCode(codeTable[src[i] + 128], codeLengthTable[src[i] + 128]);
+	}
+} // encode
+
+// Desc: Pad the pending bits (if any) with 0's to a complete byte.
+void BitBuffer::flush() {
+	if (numOfBits > 0)
+		writeCode(0, 8 - numOfBits);
+} // flush
+
+// Desc: Return the number of complete bytes in the destination.
+unsigned BitBuffer::getLength() const {
+	return length;
+} // getLength
+
+// Desc: Return the number of pending bits.
+unsigned BitBuffer::getNumOfBits() const {
+	return numOfBits;
+} // getNumOfBits
+
+// Desc: Return the pending bits, aligned to the most significant
+//       bit of a byte. The other bits are 0's.
+char BitBuffer::getPendingByte() const {
+	return (char)((bits << (8 - numOfBits)) & 0xFF);
+} // getPendingByte
+
+// End of BitBuffer.cpp
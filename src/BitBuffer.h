@@ -0,0 +1,113 @@
+/*
+ * BitBuffer.h
+ *
+ * Description: It packs Huffman codes into a memory buffer.
+ *              Bits are written from the most significant bit of each
+ *              byte, the same order as OutBitStream::loadNextByte().
+ *
+ *
+ */
+
+#ifndef BITBUFFER_H
+#define BITBUFFER_H
+
+#include <cstddef>
+
+// Desc: Codes of all pairs of characters, so that the encoder handles
+//       two characters per table lookup. A pair whose codes are longer
+//       than MAX_PAIR_CODE_LENGTH bits together is not in the table
+//       (length 0), and its characters are encoded one at a time.
+class PairCodeTable {
+public:
+	static const unsigned MAX_PAIR_CODE_LENGTH = 32;
+	static const unsigned NUM_OF_PAIRS = 256 * 256;
+
+	// Desc: Concatenated code of a pair.
+	struct Entry {
+		unsigned code;
+		unsigned length;		// 0 if the pair is not in the table.
+	};
+
+private:
+	Entry *entries;				// Indexed by getPair().
+
+	// Copying is not allowed.
+	PairCodeTable(const PairCodeTable &);
+	PairCodeTable &operator = (const PairCodeTable &);
+
+public:
+
+	// Constructor and destructor
+	//       The table is built from the code tables of one Huffman tree.
+	PairCodeTable(const unsigned *codeTable, const unsigned *codeLengthTable);
+	~PairCodeTable();
+
+	// Desc: Return the index of the pair of characters "first", "second".
+	static unsigned getPair(char first, char second) {
+		return ((unsigned)(unsigned char)first << 8) | (unsigned char)second;
+	}
+
+	// Desc: Return the code of a pair.
+	const Entry &getEntry(unsigned pair) const {
+		return entries[pair];
+	}
+
+}; // PairCodeTable
+
+class BitBuffer {
+private:
+	char *data;					// Destination of the complete bytes.
+	unsigned length;			// Number of complete bytes in "data".
+	unsigned long long bits;	// Pending bits (right aligned).
+	unsigned numOfBits;			// Number of pending bits, always < 8.
+public:
+
+	// Constructor
+	BitBuffer();
+
+	// Desc: Set the destination of the following complete bytes.
+	// Post: The length is reset to 0. Pending bits are kept, so that
+	//       a code stream can be continued across several buffers.
+	void setDestination(char *data);
+
+	// Desc: Append the "codeLength" least significant bits of "code".
+	//  Pre: codeLength <= 32.
+	void writeCode(unsigned code, unsigned codeLength);
+
+	// Desc: Encode "size" characters using the code tables. If "pairs"
+	//       is not NULL, two characters are encoded per lookup wherever
+	//       the pair is in the table. The result is the same.
+	//  Pre: The destination has room for 4 * size bytes.
+	void encode(const char *src, unsigned size, const unsigned *codeTable, const unsigned *codeLengthTable, 
+		const PairCodeTable *pairs = NULL);
+
+	// Desc: Pad the pending bits (if any) with 0's to a complete byte.
+	void flush();
+
+	// Desc: Return the number of complete bytes in the destination.
+	unsigned getLength() const;
+
+	// Desc: Return the number of pending bits.
+	unsigned getNumOfBits() const;
+
+	// Desc: Return the pending bits, aligned to the most significant
+	//       bit of a byte. The other bits are 0's.
+	char getPendingByte() const;
+
+}; // BitBuffer
+
+// Desc: Append the "codeLength" least significant bits of "code".
+//       Defined here so that it can be inlined into the encoding loops.
+//  Pre: codeLength <= 32.
+inline void BitBuffer::writeCode(unsigned code, unsigned codeLength) {
+	bits = (bits << codeLength) | code;
+	numOfBits += codeLength;
+	while (numOfBits >= 8) {
+		numOfBits -= 8;
+		data[length++] = (char)(bits >> numOfBits);
+	}
+} // writeCode
+
+#endif
+
+// End of BitBuffer.h
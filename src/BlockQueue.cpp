@@ -0,0 +1,84 @@
+/*
+ * BlockQueue.cpp
+ *
+ * Description: Bounded ring buffer of data blocks, shared by the
+ *              stages of the pipelined compression / decompression.
+ * Class Invariant: The number of queued blocks never exceeds the capacity.
+ *                  Producers wait while the queue is full and consumers
+ *                  wait while it is empty.
+ *
+ *
+ */
+
+#include <cstddef>
+#include "BlockQueue.h"
+#include "Trace.h"
+
+// Desc: Constructor
+Block::Block(unsigned capacity) {
+	this -> capacity = capacity;
+	size = 0;
+	data = new char[capacity];
+} // Constructor
+
+// Desc: Destructor
+Block::~Block() {
+	delete [] data;
+} // Destructor
+
+// Desc: Constructor
+BlockQueue::BlockQueue(int capacity) {
+	this -> capacity = capacity;
+	arr = new Block*[capacity];
+	head = 0;
+	length = 0;
+	isClosed = false;
+} // Constructor
+
+// Desc: Destructor
+//       The queued blocks are owned by the caller, not the queue.
+BlockQueue::~BlockQueue() {
+	delete [] arr;
+} // Destructor
+
+// Desc: Append a block to the queue.
+// Post: Waits until there is room in the queue.
+void BlockQueue::push(Block *block) {
+	unique_lock<mutex> guard(lock);
+	if (length == capacity) {
+		TRACE_SCOPE("wait for room");
+		while (length == capacity)
+			notFull.wait(guard);
+	}
+	arr[(head + length) % capacity] = block;
+	length++;
+	notEmpty.notify_one();
+} // push
+
+// Desc: Remove the oldest block from the queue.
+// Post: Waits until a block is available. Returns NULL if the queue
+//       is closed and empty.
+Block *BlockQueue::pop() {
+	unique_lock<mutex> guard(lock);
+	if (length == 0 && !isClosed) {
+		TRACE_SCOPE("wait for block");
+		while (length == 0 && !isClosed)
+			notEmpty.wait(guard);
+	}
+	if (length == 0)
+		return NULL;
+	Block *block = arr[head];
+	head = (head + 1) % capacity;
+	length--;
+	notFull.notify_one();
+	return block;
+} // pop
+
+// Desc: Mark the end of the data. Waiting consumers are woken up.
+void BlockQueue::close() {
+	unique_lock<mutex> guard(lock);
+	isClosed = true;
+	notEmpty.notify_all();
+} // close
+
+// End of BlockQueue.cpp
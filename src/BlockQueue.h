@@ -0,0 +1,70 @@
+/*
+ * BlockQueue.h
+ *
+ * Description: Bounded ring buffer of data blocks, shared by the
+ *              stages of the pipelined compression / decompression.
+ * Class Invariant: The number of queued blocks never exceeds the capacity.
+ *                  Producers wait while the queue is full and consumers
+ *                  wait while it is empty.
+ *
+ *
+ */
+
+#ifndef BLOCKQUEUE_H
+#define BLOCKQUEUE_H
+
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Desc: A chunk of data passed between pipeline stages.
+class Block {
+public:
+	char *data;			// Data of the block.
+	unsigned size;		// Number of bytes in use.
+	unsigned capacity;	// Number of bytes allocated.
+
+	// Constructor and destructor
+	Block(unsigned capacity);
+	~Block();
+}; // Block
+
+class BlockQueue {
+private:
+	Block **arr;		// Ring buffer
+	int capacity;
+	int head;			// Index of the oldest block.
+	int length;
+	bool isClosed;		// No more blocks will be pushed.
+
+	mutex lock;
+	condition_variable notFull, notEmpty;
+
+	// Copying a queue is not allowed.
+	BlockQueue(const BlockQueue &);
+	BlockQueue &operator = (const BlockQueue &);
+
+public:
+
+	// Constructor and destructor
+	BlockQueue(int capacity);
+	~BlockQueue();
+
+	// Desc: Append a block to the queue.
+	// Post: Waits until there is room in the queue.
+	void push(Block *block);
+
+	// Desc: Remove the oldest block from the queue.
+	// Post: Waits until a block is available. Returns NULL if the queue
+	//       is closed and empty.
+	Block *pop();
+
+	// Desc: Mark the end of the data. Waiting consumers are woken up.
+	void close();
+
+}; // BlockQueue
+
+#endif
+
+// End of BlockQueue.h
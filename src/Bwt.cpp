@@ -0,0 +1,488 @@
+/*
+ * Bwt.cpp
+ *
+ * Description: BWT method. Each block of 1 MB is sorted with the
+ *              Burrows-Wheeler transform, which groups the characters
+ *              by the text that follows them. Move-to-front then turns
+ *              the groups into runs of small numbers, the runs of 0's
+ *              are coded by their length, and the result is Huffman
+ *              coded with one tree of 257 symbols per block. The blocks
+ *              are independent, so several are transformed at once.
+ *
+ *              The suffix array behind the transform is built with
+ *              SA-IS (induced sorting), in linear time.
+ *
+ *              Block format: [block size][primary index][table size]
+ *                            [coded size][weights][coded symbols]
+ *
+ *
+ */
+
+#include <vector>
+#include <thread>
+#include <cstring>
+#include "Bwt.h"
+#include "HuffmanTree.h"
+#include "DecodeTable.h"
+#include "BitBuffer.h"
+#include "Trace.h"
+
+using namespace std;
+
+// Desc: Weights of an alphabet other than the 256 characters.
+//       Implemented in "FileHeaderHandler.cpp".
+int weightsSize(const unsigned *, unsigned);
+int writeWeights(OutBitStream &, const unsigned *, unsigned);
+int parseWeights(const char *, unsigned, unsigned *, unsigned);
+
+// Number of source bytes transformed at once.
+static const unsigned BWT_BLOCK_SIZE = 1 << 20;
+
+// Symbols: RUNA and RUNB write the length of a run of 0's in bijective
+// base 2, least significant digit first (RUNA = 1, RUNB = 2). Any other
+// move-to-front index "i" is symbol "i + 1".
+static const unsigned RUNA = 0;
+static const unsigned RUNB = 1;
+static const unsigned NUM_OF_BWT_SYMBOLS = 257;
+
+// Sizes of the fields of a block.
+static const unsigned BLOCK_SIZE_SIZE = 4;
+static const unsigned PRIMARY_INDEX_SIZE = 4;
+static const unsigned TABLE_SIZE_SIZE = 4;
+static const unsigned CODED_SIZE_SIZE = 4;
+static const unsigned BLOCK_HEADER_SIZE = BLOCK_SIZE_SIZE + PRIMARY_INDEX_SIZE + TABLE_SIZE_SIZE + CODED_SIZE_SIZE;
+
+// Desc: One block on its way through the transform and the coder.
+class BwtBlock {
+public:
+	vector<char> data;			// Source bytes, or decoded bytes.
+	unsigned size;				// Number of source bytes.
+	unsigned primaryIndex;		// Row of the whole block in the sorted rotations.
+	unsigned weights[NUM_OF_BWT_SYMBOLS];
+	vector<char> coded;			// Coded symbols, after the weights when decoding.
+	unsigned codedSize;
+	unsigned tableSize;			// Size of the weights when decoding.
+	char *output;				// Where the decoded bytes go.
+	bool isValid;				// The block has been decoded.
+}; // BwtBlock
+
+
+// Suffix array (SA-IS)
+// The string "s" of "n" integers below "K" ends with a unique 0. Each
+// suffix is S-type if it is smaller than the next one, L-type otherwise.
+// An S-type suffix after an L-type one is a leftmost S-type (LMS) suffix.
+// Sorting the LMS suffixes is enough to induce the order of all others.
+
+// Desc: Return true if the suffix at "i" is an LMS suffix.
+static bool isLms(const vector<bool> &isS, int i) {
+	return i > 0 && isS[i] && !isS[i - 1];
+} // isLms
+
+// Desc: Compute the start (or the end) of the bucket of each integer
+//       in the suffix array.
+static void getBuckets(const int *s, int n, int K, vector<int> &bucket, bool isEnd) {
+	bucket.assign(K, 0);
+	for (int i = 0; i < n; i++)
+		bucket[s[i]]++;
+	int sum = 0;
+	for (int c = 0; c < K; c++) {
+		sum += bucket[c];
+		bucket[c] = isEnd ? sum : sum - bucket[c];
+	}
+} // getBuckets
+
+// Desc: Place the L-type suffixes from the ones already in "sa",
+//       scanning from left to right, then the S-type ones from right
+//       to left.
+static void induce(const vector<bool> &isS, int *sa, const int *s, int n, int K, vector<int> &bucket) {
+	getBuckets(s, n, K, bucket, false);
+	for (int i = 0; i < n; i++) {
+		int j = sa[i] - 1;
+		if (sa[i] > 0 && !isS[j])
+			sa[bucket[s[j]]++] = j;
+	}
+	getBuckets(s, n, K, bucket, true);
+	for (int i = n - 1; i >= 0; i--) {
+		int j = sa[i] - 1;
+		if (sa[i] > 0 && isS[j])
+			sa[--bucket[s[j]]] = j;
+	}
+} // induce
+
+// Desc: Build the suffix array "sa" of "s".
+//  Pre: "s" holds "n" integers below "K", and ends with a unique 0.
+static void buildSuffixArray(const int *s, int *sa, int n, int K) {
+	vector<bool> isS(n);
+	isS[n - 1] = true;
+	for (int i = n - 2; i >= 0; i--)
+		isS[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && isS[i + 1]);
+
+	// Sort the LMS substrings (from one LMS suffix to the next).
+	vector<int> bucket;
+	getBuckets(s, n, K, bucket, true);
+	for (int i = 0; i < n; i++)
+		sa[i] = -1;
+	for (int i = 1; i < n; i++) {
+		if (isLms(isS, i))
+			sa[--bucket[s[i]]] = i;
+	}
+	induce(isS, sa, s, n, K, bucket);
+
+	// Name them in order, equal substrings with the same name. The names
+	// are kept in the order of their positions, at the end of "sa".
+	int n1 = 0;
+	for (int i = 0; i < n; i++) {
+		if (isLms(isS, sa[i]))
+			sa[n1++] = sa[i];
+	}
+	for (int i = n1; i < n; i++)
+		sa[i] = -1;
+	int name = 0, prev = -1;
+	for (int i = 0; i < n1; i++) {
+		int pos = sa[i];
+		bool isDifferent = false;
+		for (int d = 0; d < n; d++) {
+			if (prev == -1 || s[pos + d] != s[prev + d] || isS[pos + d] != isS[prev + d]) {
+				isDifferent = true;
+				break;
+			} else if (d > 0 && (isLms(isS, pos + d) || isLms(isS, prev + d))) {
+				break;
+			}
+		}
+		if (isDifferent) {
+			name++;
+			prev = pos;
+		}
+		sa[n1 + pos / 2] = name - 1;
+	}
+	for (int i = n - 1, j = n - 1; i >= n1; i--) {
+		if (sa[i] >= 0)
+			sa[j--] = sa[i];
+	}
+
+	// Sort the LMS suffixes: directly if all names differ, otherwise
+	// as the suffixes of the string of names.
+	int *s1 = sa + n - n1;
+	if (name < n1) {
+		buildSuffixArray(s1, sa, n1, name);
+	} else {
+		for (int i = 0; i < n1; i++)
+			sa[s1[i]] = i;
+	}
+
+	// Induce the order of all suffixes from the sorted LMS suffixes.
+	getBuckets(s, n, K, bucket, true);
+	for (int i = 1, j = 0; i < n; i++) {
+		if (isLms(isS, i))
+			s1[j++] = i;
+	}
+	for (int i = 0; i < n1; i++)
+		sa[i] = s1[sa[i]];
+	for (int i = n1; i < n; i++)
+		sa[i] = -1;
+	for (int i = n1 - 1; i >= 0; i--) {
+		int j = sa[i];
+		sa[i] = -1;
+		sa[--bucket[s[j]]] = j;
+	}
+	induce(isS, sa, s, n, K, bucket);
+} // buildSuffixArray
+
+
+// Encoding
+
+// Desc: Write the Burrows-Wheeler transform of the "size" bytes of "data"
+//       to "last": the last column of its sorted rotations, with an end
+//       marker that sorts first. The marker itself is left out.
+// Post: Returns the row of the marker (the primary index).
+static unsigned transform(const char *data, unsigned size, char *last) {
+	vector<int> s(size + 1), sa(size + 1);
+	for (unsigned i = 0; i < size; i++)
+		s[i] = (unsigned char)data[i] + 1;
+	s[size] = 0;
+	buildSuffixArray(s.data(), sa.data(), size + 1, NUM_OF_BWT_SYMBOLS);
+
+	unsigned primaryIndex = 0;
+	for (unsigned i = 0, j = 0; i <= size; i++) {
+		if (sa[i] == 0)
+			primaryIndex = i;
+		else
+			last[j++] = data[sa[i] - 1];
+	}
+	return primaryIndex;
+} // transform
+
+// Desc: Append the symbols of a run of "length" 0's to "symbols".
+static void writeRun(unsigned length, vector<unsigned short> &symbols) {
+	while (length > 0) {
+		if ((length & 1) != 0) {
+			symbols.push_back(RUNA);
+			length = (length - 1) / 2;
+		} else {
+			symbols.push_back(RUNB);
+			length = (length - 2) / 2;
+		}
+	}
+} // writeRun
+
+// Desc: Transform and code one block.
+static void encodeBlock(BwtBlock *block) {
+	TRACE_SCOPE("bwt block");
+	unsigned size = block -> size;
+	vector<char> last(size);
+	block -> primaryIndex = transform(block -> data.data(), size, last.data());
+
+	// Move-to-front, with the runs of 0's coded by their length.
+	unsigned char order[256];
+	for (unsigned i = 0; i < 256; i++)
+		order[i] = i;
+	vector<unsigned short> symbols;
+	symbols.reserve(size);
+	unsigned run = 0;
+	for (unsigned i = 0; i < size; i++) {
+		unsigned char c = last[i];
+		if (order[0] == c) {
+			run++;
+			continue;
+		}
+		writeRun(run, symbols);
+		run = 0;
+		unsigned index = 1;
+		while (order[index] != c)
+			index++;
+		memmove(order + 1, order, index);
+		order[0] = c;
+		symbols.push_back(index + 1);
+	}
+	writeRun(run, symbols);
+
+	for (unsigned i = 0; i < NUM_OF_BWT_SYMBOLS; i++)
+		block -> weights[i] = 0;
+	for (unsigned i = 0; i < symbols.size(); i++)
+		block -> weights[symbols[i]]++;
+
+	HuffmanTree tree(block -> weights, NUM_OF_BWT_SYMBOLS);
+	const unsigned *codeTable = tree.getCodeTable();
+	const unsigned *codeLengthTable = tree.getCodeLengthTable();
+	block -> coded.resize(4 * symbols.size() + 8);
+	BitBuffer buffer;
+	buffer.setDestination(block -> coded.data());
+	for (unsigned i = 0; i < symbols.size(); i++)
+		buffer.writeCode(codeTable[symbols[i]], codeLengthTable[symbols[i]]);
+	buffer.flush();
+	block -> codedSize = buffer.getLength();
+} // encodeBlock
+
+// Desc: Write a coded block to "out".
+// Post: Returns the size of the block (in bytes).
+static unsigned writeBlock(OutBitStream &out, const BwtBlock &block) {
+	unsigned tableSize = weightsSize(block.weights, NUM_OF_BWT_SYMBOLS);
+	out.writeValue(block.size, BLOCK_SIZE_SIZE);
+	out.writeValue(block.primaryIndex, PRIMARY_INDEX_SIZE);
+	out.writeValue(tableSize, TABLE_SIZE_SIZE);
+	out.writeValue(block.codedSize, CODED_SIZE_SIZE);
+	writeWeights(out, block.weights, NUM_OF_BWT_SYMBOLS);
+	out.writeBlock(block.coded.data(), block.codedSize);
+	return BLOCK_HEADER_SIZE + tableSize + block.codedSize;
+} // writeBlock
+
+// Desc: Encode the rest of the source file with the BWT method, using
+//       "numOfThreads" threads, and write the body of the member to "out".
+//       The source is read through "filter" if it is not NULL.
+// Post: Returns the size of the body (in bytes).
+unsigned long long encodeBwt(InBitStream &in, OutBitStream &out, unsigned numOfThreads, Filter *filter) {
+	TRACE_SCOPE("encode");
+	vector<BwtBlock> blocks;	// Only as many as the source fills.
+	unsigned long long bodySize = 0;
+	unsigned count;
+	do {
+		// Read one block per thread, and transform them together.
+		for (count = 0; count < numOfThreads; count++) {
+			if (count == blocks.size())
+				blocks.resize(count + 1);
+			BwtBlock &block = blocks[count];
+			block.data.resize(BWT_BLOCK_SIZE);
+			if (filter != NULL)
+				block.size = filter -> read(in, block.data.data(), BWT_BLOCK_SIZE);
+			else
+				block.size = in.readBlock(block.data.data(), BWT_BLOCK_SIZE);
+			if (block.size == 0)
+				break;
+		}
+		if (count == 1) {
+			encodeBlock(&blocks[0]);
+		} else {
+			vector<thread> workers;
+			for (unsigned i = 0; i < count; i++)
+				workers.push_back(thread(encodeBlock, &blocks[i]));
+			for (unsigned i = 0; i < count; i++)
+				workers[i].join();
+		}
+		for (unsigned i = 0; i < count; i++)
+			bodySize += writeBlock(out, blocks[i]);
+	} while (count == numOfThreads);
+	return bodySize;
+} // encodeBwt
+
+
+// Decoding
+
+// Desc: Write the "size" bytes whose transform is "last" (see
+//       transform()) to "dst".
+// Post: Return false if "primaryIndex" is not valid.
+static bool inverseTransform(const char *last, unsigned size, unsigned primaryIndex, char *dst) {
+	if (primaryIndex > size || (primaryIndex == 0 && size > 0))
+		return false;
+
+	// "link[i]" holds the row of the rotation that starts one character
+	// before the rotation of row "i", and (in its low 8 bits) that
+	// character. Row 0 starts with the marker.
+	unsigned start[256] = {0};
+	for (unsigned i = 0; i < size; i++)
+		start[(unsigned char)last[i]]++;
+	for (unsigned c = 0, sum = 1; c < 256; c++) {
+		unsigned count = start[c];
+		start[c] = sum;
+		sum += count;
+	}
+	vector<unsigned> link(size + 1);
+	for (unsigned row = 0; row < primaryIndex; row++) {
+		unsigned char c = last[row];
+		link[row] = start[c]++ << 8 | c;
+	}
+	for (unsigned row = primaryIndex + 1; row <= size; row++) {
+		unsigned char c = last[row - 1];
+		link[row] = start[c]++ << 8 | c;
+	}
+
+	// Follow the rotations backwards from the end of the block.
+	unsigned row = 0;
+	for (unsigned i = size; i > 0; i--) {
+		if (row == primaryIndex)
+			return false;
+		dst[i - 1] = link[row];
+		row = link[row] >> 8;
+	}
+	return row == primaryIndex;
+} // inverseTransform
+
+// Desc: Decode and transform back one block.
+static void decodeBlock(BwtBlock *block) {
+	TRACE_SCOPE("bwt block");
+	block -> isValid = false;
+	unsigned size = block -> size;
+	if (parseWeights(block -> coded.data(), block -> tableSize, block -> weights, NUM_OF_BWT_SYMBOLS) != (int)block -> tableSize)
+		return;
+
+	HuffmanTree tree(block -> weights, NUM_OF_BWT_SYMBOLS);
+	DecodeTable table(tree);
+	BitReader reader(block -> coded.data() + block -> tableSize, block -> coded.data() + block -> tableSize + block -> codedSize);
+
+	// Undo the run lengths and move-to-front.
+	unsigned char order[256];
+	for (unsigned i = 0; i < 256; i++)
+		order[i] = i;
+	vector<char> last(size);
+	unsigned length = 0, run = 0, weight = 1;
+	unsigned symbol;
+	while (length + run < size) {
+		if (reader.readSymbol(table, symbol) == false)
+			return;
+		if (symbol <= RUNB) {
+			run += (symbol + 1) * weight;
+			weight <<= 1;
+			if (weight > size)
+				return;
+			continue;
+		}
+		memset(last.data() + length, order[0], run);
+		length += run;
+		run = 0;
+		weight = 1;
+
+		unsigned index = symbol - 1;
+		unsigned char c = order[index];
+		memmove(order + 1, order, index);
+		order[0] = c;
+		last[length++] = c;
+	}
+	if (length + run != size)
+		return;
+	memset(last.data() + length, order[0], run);
+
+	block -> isValid = inverseTransform(last.data(), size, block -> primaryIndex, block -> output);
+} // decodeBlock
+
+// Desc: Decode the "bodySize" bytes of BWT coded data at the current
+//       position of "in", using "numOfThreads" threads. The
+//       "originalSize" decoded bytes are written to "dst" if it is not
+//       NULL, otherwise to "out" (through "filter" if it is not NULL).
+// Post: Return false if the data is not valid.
+bool decodeBwt(InBitStream &in, unsigned long long bodySize, unsigned originalSize, char *dst,
+	OutBitStream &out, unsigned numOfThreads, Filter *filter) {
+	TRACE_SCOPE("decode");
+	vector<BwtBlock> blocks;	// Only as many as the body holds.
+	unsigned long long consumed = 0;
+	unsigned produced = 0;
+	while (produced < originalSize) {
+
+		// Read one block per thread.
+		unsigned count = 0;
+		unsigned end = produced;
+		while (count < numOfThreads && end < originalSize) {
+			if (count == blocks.size())
+				blocks.resize(count + 1);
+			BwtBlock &block = blocks[count];
+			char header[BLOCK_HEADER_SIZE];
+			if (bodySize - consumed < BLOCK_HEADER_SIZE || in.readBlock(header, BLOCK_HEADER_SIZE) != BLOCK_HEADER_SIZE)
+				return false;
+			block.size = 0;
+			block.primaryIndex = 0;
+			block.tableSize = 0;
+			block.codedSize = 0;
+			memcpy(&block.size, header, BLOCK_SIZE_SIZE);
+			memcpy(&block.primaryIndex, header + BLOCK_SIZE_SIZE, PRIMARY_INDEX_SIZE);
+			memcpy(&block.tableSize, header + BLOCK_SIZE_SIZE + PRIMARY_INDEX_SIZE, TABLE_SIZE_SIZE);
+			memcpy(&block.codedSize, header + BLOCK_SIZE_SIZE + PRIMARY_INDEX_SIZE + TABLE_SIZE_SIZE, CODED_SIZE_SIZE);
+			consumed += BLOCK_HEADER_SIZE;
+			if (block.size == 0 || block.size > BWT_BLOCK_SIZE || block.size > originalSize - end ||
+				(unsigned long long)block.tableSize + block.codedSize > bodySize - consumed)
+				return false;
+			block.coded.resize(block.tableSize + block.codedSize);
+			if (in.readBlock(block.coded.data(), block.coded.size()) != block.coded.size())
+				return false;
+			consumed += block.coded.size();
+
+			if (dst != NULL) {
+				block.output = dst + end;
+			} else {
+				block.data.resize(block.size);
+				block.output = block.data.data();
+			}
+			end += block.size;
+			count++;
+		}
+
+		if (count == 1) {
+			decodeBlock(&blocks[0]);
+		} else {
+			vector<thread> workers;
+			for (unsigned i = 0; i < count; i++)
+				workers.push_back(thread(decodeBlock, &blocks[i]));
+			for (unsigned i = 0; i < count; i++)
+				workers[i].join();
+		}
+		for (unsigned i = 0; i < count; i++) {
+			if (blocks[i].isValid == false)
+				return false;
+			if (dst == NULL && filter != NULL)
+				filter -> write(out, blocks[i].output, blocks[i].size);
+			else if (dst == NULL)
+				out.writeBlock(blocks[i].output, blocks[i].size);
+		}
+		produced = end;
+	}
+	return consumed == bodySize;
+} // decodeBwt
+
+// End of Bwt.cpp
@@ -0,0 +1,38 @@
+/*
+ * Bwt.h
+ *
+ * Description: BWT method. Each block of 1 MB is sorted with the
+ *              Burrows-Wheeler transform, which groups the characters
+ *              by the text that follows them. Move-to-front then turns
+ *              the groups into runs of small numbers, the runs of 0's
+ *              are coded by their length, and the result is Huffman
+ *              coded with one tree of 257 symbols per block. The blocks
+ *              are independent, so several are transformed at once.
+ *
+ *
+ */
+
+#ifndef BWT_H
+#define BWT_H
+
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "Filter.h"
+
+// Desc: Encode the rest of the source file with the BWT method, using
+//       "numOfThreads" threads, and write the body of the member to "out".
+//       The source is read through "filter" if it is not NULL.
+// Post: Returns the size of the body (in bytes).
+unsigned long long encodeBwt(InBitStream &in, OutBitStream &out, unsigned numOfThreads, Filter *filter);
+
+// Desc: Decode the "bodySize" bytes of BWT coded data at the current
+//       position of "in", using "numOfThreads" threads. The
+//       "originalSize" decoded bytes are written to "dst" if it is not
+//       NULL, otherwise to "out" (through "filter" if it is not NULL).
+// Post: Return false if the data is not valid.
+bool decodeBwt(InBitStream &in, unsigned long long bodySize, unsigned originalSize, char *dst,
+	OutBitStream &out, unsigned numOfThreads, Filter *filter);
+
+#endif
+
+// End of Bwt.h
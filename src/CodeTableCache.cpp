@@ -0,0 +1,132 @@
+/*
+ * CodeTableCache.cpp
+ *
+ * Description: Ready-to-use encode / decode tables, and an in-process
+ *              cache of them keyed by the frequency table.
+ *              Files that carry an identical frequency table share one
+ *              Huffman tree instead of rebuilding it every time.
+ * Class Invariant: The cache holds at most "capacity" entries. The least
+ *                  recently used entry is evicted first.
+ *
+ *
+ */
+
+#include "CodeTableCache.h"
+#include "PriorityQueue.h"
+#include "Trace.h"
+
+// Desc: Compute the id of a frequency table.
+//       Implemented in "StaticTable.cpp".
+unsigned computeTableId(const unsigned *bitVector);
+
+// Desc: Constructor
+HuffmanCode::HuffmanCode(FrequencyCounter &counter) {
+	TRACE_SCOPE("build code tables");
+	const unsigned *bitVector = counter.getBitVector();
+	for (int i = 0; i < 256; i++)
+		weights[i] = bitVector[i];
+
+	PriorityQueue pq;
+	counter.createPriorityQueue(pq);	// Create Priority Queue.
+	tree = new HuffmanTree(pq);			// Create Huffman Tree.
+	decodeTable = new DecodeTable(*tree);
+} // Constructor
+
+// Desc: Destructor
+HuffmanCode::~HuffmanCode() {
+	delete decodeTable;
+	delete tree;
+} // Destructor
+
+// Desc: Return true if it is built from the given frequency table.
+bool HuffmanCode::hasWeights(const unsigned *bitVector) const {
+	for (int i = 0; i < 256; i++) {
+		if (weights[i] != bitVector[i])
+			return false;
+	}
+	return true;
+} // hasWeights
+
+// Desc: Return the Huffman tree.
+HuffmanTree &HuffmanCode::getTree() const {
+	return *tree;
+} // getTree
+
+// Desc: Return the decode table.
+const DecodeTable &HuffmanCode::getDecodeTable() const {
+	return *decodeTable;
+} // getDecodeTable
+
+// Desc: Return the number of bytes needed to encode characters
+//       occurring "counts[i]" times each (indexed like the bit vector).
+unsigned long long HuffmanCode::getEncodedSize(const unsigned *counts) const {
+	const unsigned *codeLengthTable = tree -> getCodeLengthTable();
+	unsigned long long numOfBits = 0;
+	for (int i = 0; i < 256; i++)
+		numOfBits += (unsigned long long)counts[i] * codeLengthTable[i];
+	return (numOfBits + 7) / 8;		// The last byte is padded.
+} // getEncodedSize
+
+// Desc: Return the number of bytes needed to encode the characters
+//       of the frequency table it is built from.
+unsigned long long HuffmanCode::getEncodedSize() const {
+	return getEncodedSize(weights);
+} // getEncodedSize
+
+
+// Desc: Constructor
+CodeTableCache::CodeTableCache(unsigned capacity) {
+	this -> capacity = capacity > 0 ? capacity : 1;
+	hits = 0;
+	misses = 0;
+} // Constructor
+
+// Desc: Return the tables built from the frequency table of "counter".
+//       They are built and cached on a miss.
+// Post: The returned tables stay valid even if they are evicted.
+shared_ptr<HuffmanCode> CodeTableCache::get(FrequencyCounter &counter) {
+	const unsigned *bitVector = counter.getBitVector();
+	unsigned key = computeTableId(bitVector);
+
+	lock_guard<mutex> guard(lock);
+	map<unsigned, list<Entry>::iterator>::iterator it = index.find(key);
+	if (it != index.end()) {
+		// Different tables may share a key, so check the weights as well.
+		if (it -> second -> second -> hasWeights(bitVector)) {
+			hits++;
+			entries.splice(entries.begin(), entries, it -> second);
+			return entries.front().second;
+		}
+		entries.erase(it -> second);
+		index.erase(it);
+	}
+
+	misses++;
+	shared_ptr<HuffmanCode> code(new HuffmanCode(counter));
+	entries.push_front(Entry(key, code));
+	index[key] = entries.begin();
+
+	// Evict the least recently used entry.
+	if (entries.size() > capacity) {
+		index.erase(entries.back().first);
+		entries.pop_back();
+	}
+	return code;
+} // get
+
+// Desc: Return the number of cache hits.
+unsigned CodeTableCache::getHits() const {
+	return hits;
+} // getHits
+
+// Desc: Return the number of cache misses.
+unsigned CodeTableCache::getMisses() const {
+	return misses;
+} // getMisses
+
+// Desc: Return the number of cached entries.
+unsigned CodeTableCache::getSize() const {
+	return entries.size();
+} // getSize
+
+// End of CodeTableCache.cpp
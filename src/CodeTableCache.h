@@ -0,0 +1,99 @@
+/*
+ * CodeTableCache.h
+ *
+ * Description: Ready-to-use encode / decode tables, and an in-process
+ *              cache of them keyed by the frequency table.
+ *              Files that carry an identical frequency table share one
+ *              Huffman tree instead of rebuilding it every time.
+ * Class Invariant: The cache holds at most "capacity" entries. The least
+ *                  recently used entry is evicted first.
+ *
+ *
+ */
+
+#ifndef CODETABLECACHE_H
+#define CODETABLECACHE_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "FrequencyCounter.h"
+#include "HuffmanTree.h"
+#include "DecodeTable.h"
+
+using namespace std;
+
+// Desc: Huffman tree, code tables and decode table built from
+//       one frequency table.
+class HuffmanCode {
+private:
+	unsigned weights[256];		// The frequency table it is built from.
+	HuffmanTree *tree;
+	DecodeTable *decodeTable;
+
+	// Copying is not allowed.
+	HuffmanCode(const HuffmanCode &);
+	HuffmanCode &operator = (const HuffmanCode &);
+
+public:
+
+	// Constructor and destructor
+	HuffmanCode(FrequencyCounter &counter);
+	~HuffmanCode();
+
+	// Desc: Return true if it is built from the given frequency table.
+	bool hasWeights(const unsigned *bitVector) const;
+
+	// Desc: Return the Huffman tree.
+	HuffmanTree &getTree() const;
+
+	// Desc: Return the decode table.
+	const DecodeTable &getDecodeTable() const;
+
+	// Desc: Return the number of bytes needed to encode characters
+	//       occurring "counts[i]" times each (indexed like the bit vector).
+	unsigned long long getEncodedSize(const unsigned *counts) const;
+
+	// Desc: Return the number of bytes needed to encode the characters
+	//       of the frequency table it is built from.
+	unsigned long long getEncodedSize() const;
+
+}; // HuffmanCode
+
+class CodeTableCache {
+private:
+	typedef pair<unsigned, shared_ptr<HuffmanCode> > Entry;
+
+	list<Entry> entries;	// Most recently used first.
+	map<unsigned, list<Entry>::iterator> index;
+	unsigned capacity;
+	unsigned hits, misses;
+	mutex lock;
+
+	// Copying is not allowed.
+	CodeTableCache(const CodeTableCache &);
+	CodeTableCache &operator = (const CodeTableCache &);
+
+public:
+
+	// Constructor
+	CodeTableCache(unsigned capacity = 64);
+
+	// Desc: Return the tables built from the frequency table of "counter".
+	//       They are built and cached on a miss.
+	// Post: The returned tables stay valid even if they are evicted.
+	shared_ptr<HuffmanCode> get(FrequencyCounter &counter);
+
+	// Desc: Return the number of cache hits / misses.
+	unsigned getHits() const;
+	unsigned getMisses() const;
+
+	// Desc: Return the number of cached entries.
+	unsigned getSize() const;
+
+}; // CodeTableCache
+
+#endif
+
+// End of CodeTableCache.h
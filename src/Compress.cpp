@@ -8,12 +8,26 @@
  */
 
 #include <iostream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
 #include "InBitStream.h"
 #include "OutBitStream.h"
 #include "FrequencyCounter.h"
 #include "PriorityQueue.h"
 #include "HuffmanTree.h"
 #include "HeaderFormat.h"
+#include "CodeTableCache.h"
+#include "Options.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "Trailer.h"
+#include "MappedFile.h"
+#include "BitBuffer.h"
+#include "Lz77.h"
+#include "Bwt.h"
+#include "HuffmanBlocks.h"
+#include "Filter.h"
 
 using namespace std;
 
@@ -21,17 +35,244 @@ using namespace std;
 //       the compressed file.
 //       Implemented in "FileHeaderHandler.cpp".
 int writeFileHeader(OutBitStream &, FrequencyCounter &);
+int writeStaticFileHeader(OutBitStream &, unsigned);
+int writeExtendedFileHeader(OutBitStream &, char, char, unsigned);
+
+// Desc: Load a pre-trained static table.
+//       Implemented in "StaticTable.cpp".
+bool loadStaticTable(const char *, FrequencyCounter &, unsigned &);
+
+// Desc: Pipelined counting and encoding.
+//       Implemented in "Pipeline.cpp".
+void countPipelined(InBitStream &, FrequencyCounter &);
+void encodePipelined(InBitStream &, OutBitStream &, unsigned *, unsigned *, const PairCodeTable *);
+
+// Desc: Multi-threaded encoding.
+//       Implemented in "ParallelEncode.cpp".
+void encodeParallel(InBitStream &, OutBitStream &, unsigned *, unsigned *, const PairCodeTable *, unsigned);
+bool encodeParallelInPlace(InBitStream &, char *, unsigned long long, unsigned *, unsigned *, const PairCodeTable *, unsigned);
+
+// Size of the blocks read by the in-place encoder, in bytes.
+static const unsigned ENCODE_BLOCK_SIZE = 64 * 1024;
+
+// Smallest source, in bytes, for which the pair code table is built.
+// Below it, filling the 64K entries costs more than it saves.
+static const unsigned PAIR_TABLE_THRESHOLD = 256 * 1024;
+
+// Number of bytes at the start of the source file from which the
+// filter is detected.
+static const unsigned FILTER_SAMPLE_SIZE = 1024 * 1024;
+
+// Desc: Encode the source file straight into the "dstSize" bytes of
+//       "dst", e.g. a mapped destination file. "pairs" (if not NULL)
+//       encodes two characters per lookup.
+// Post: The last byte is padded with 0's. Return false if the encoded
+//       data does not fill "dst" exactly, i.e. the source has changed
+//       since it was counted.
+static bool encodeInPlace(InBitStream &in, char *dst, unsigned long long dstSize, unsigned *codeTable, unsigned *codeLengthTable, const PairCodeTable *pairs) {
+	TRACE_SCOPE("encode");
+	char *block = new char[ENCODE_BLOCK_SIZE];
+	char *spare = NULL;		// Used near the end of "dst" only.
+	unsigned long long length = 0;
+	BitBuffer buffer;
+
+	// A character takes at most 4 bytes. Where "dst" may not have room
+	// for a whole block, it is encoded aside and copied if it fits.
+	unsigned size;
+	while ((size = in.readBlock(block, ENCODE_BLOCK_SIZE)) > 0 && length <= dstSize) {
+		bool hasRoom = dstSize - length >= 4 * (unsigned long long)size + 1;
+		if (hasRoom == false && spare == NULL)
+			spare = new char[4 * ENCODE_BLOCK_SIZE + 1];
+		buffer.setDestination(hasRoom ? dst + length : spare);
+		buffer.encode(block, size, codeTable, codeLengthTable, pairs);
+		if (hasRoom == false && length + buffer.getLength() <= dstSize)
+			memcpy(dst + length, spare, buffer.getLength());
+		length += buffer.getLength();
+	}
+	if (buffer.getNumOfBits() > 0 && length < dstSize) {
+		buffer.setDestination(dst + length);
+		buffer.flush();
+		length += buffer.getLength();
+	} else if (buffer.getNumOfBits() > 0) {
+		length++;
+	}
+
+	delete [] block;
+	delete [] spare;
+	return length == dstSize;
+} // encodeInPlace
+
+// Desc: Encode the source file block by block and write the
+//       compressed data to "out". "pairs" (if not NULL) encodes
+//       two characters per lookup.
+// Post: The last byte is padded with 0's.
+static void encodeStream(InBitStream &in, OutBitStream &out, unsigned *codeTable, unsigned *codeLengthTable, const PairCodeTable *pairs) {
+	TRACE_SCOPE("encode");
+	char *block = new char[ENCODE_BLOCK_SIZE];
+	char *encoded = new char[4 * ENCODE_BLOCK_SIZE + 1];
+	BitBuffer buffer;
+
+	unsigned size;
+	while ((size = in.readBlock(block, ENCODE_BLOCK_SIZE)) > 0) {
+		buffer.setDestination(encoded);
+		buffer.encode(block, size, codeTable, codeLengthTable, pairs);
+		if (buffer.getLength() > 0)
+			out.writeBlock(encoded, buffer.getLength());
+	}
+	buffer.setDestination(encoded);
+	buffer.flush();
+	if (buffer.getLength() > 0)
+		out.writeBlock(encoded, buffer.getLength());
+
+	delete [] block;
+	delete [] encoded;
+} // encodeStream
+
+// Desc: Create the destination file. In append mode, an existing
+//       compressed file is kept, "members" lists its members and the
+//       data is coded as a new member at "memberOffset", after the last
+//       one. The new member and the longer trailer always cover the old
+//       trailer, so the file never has to be truncated.
+// Post: Return false if it fails (the error is printed).
+static bool openDestination(const char *dst, const Options &opt, OutBitStream &out, 
+	vector<unsigned long long> &members, unsigned long long &memberOffset, bool &isAppending) {
+	bool isSuccessful;
+	memberOffset = 0;
+	isAppending = false;
+	if (opt.append && readTrailer(dst, members, memberOffset) && memberOffset > 0) {
+		// Members that are not indexed yet (a single-member file, or
+		// files joined with "cat") are found from their headers.
+		vector<unsigned long long> indexed;
+		indexed.swap(members);
+		if (findMembers(dst, 0, indexed.empty() ? memberOffset : indexed[0], opt, members) == false) {
+			cout << "Error: Cannot find the members of \"" << dst << "\"." << endl;
+			return false;
+		}
+		members.insert(members.end(), indexed.begin(), indexed.end());
+		isAppending = true;
+		isSuccessful = out.openFileAt(dst, memberOffset);
+	} else {
+		isSuccessful = out.openFile(dst);
+	}
+	if (isSuccessful == false) {
+		cout << "Error: Cannot create destination file \"" << dst << "\"." << endl;
+		return false;
+	}
+	return true;
+} // openDestination
+
+// Desc: Compression with a method of the extended header (see
+//       "HeaderFormat.h"): --lz77, --bwt, --rle, --symbols, --frame,
+//       --coder or --filter. The source file is read once, and the sizes
+//       are written into the header at the end.
+// Post: Return 0 if success. Otherwise, return -1.
+static int compressExtended(const char *src, const char *dst, const Options &opt) {
+	InBitStream in;
+	OutBitStream out;
+
+	if (in.openFile(src) == false) {
+		cout << "Error: Cannot open file \"" << src << "\"." << endl;
+		return -1;
+	}
+
+	vector<unsigned long long> members;
+	unsigned long long memberOffset;
+	bool isAppending;
+	if (openDestination(dst, opt, out, members, memberOffset, isAppending) == false)
+		return -1;
+
+	// Choose the filter from the start of the source file.
+	char filterType = opt.filter;
+	unsigned stride = opt.filterStride;
+	if (filterType == AUTO_FILTER || (filterType != NO_FILTER && stride == 0)) {
+		InBitStream sample(src);
+		vector<char> data(FILTER_SAMPLE_SIZE);
+		unsigned size = sample.readBlock(data.data(), FILTER_SAMPLE_SIZE);
+		detectFilter(data.data(), size, filterType, stride);
+	}
+	Filter *filter = filterType != NO_FILTER ? new Filter(filterType, stride) : NULL;
+
+	// Choose the frame size from the start of the source file.
+	unsigned frameSize = opt.frameSize;
+	if (opt.frames && frameSize == 0) {
+		InBitStream sample(src);
+		vector<char> data(FILTER_SAMPLE_SIZE);
+		unsigned size = sample.readBlock(data.data(), FILTER_SAMPLE_SIZE);
+		frameSize = detectFrameSize(data.data(), size, MAX_FRAME_SIZE);
+	}
+
+	char method = opt.runs ? RUN_METHOD : BLOCK_METHOD;
+	if (opt.symbolBits == 16)
+		method = WIDE_METHOD;
+	else if (opt.frames && frameSize > 1)
+		method = FRAME_METHOD;
+	else if (opt.coder != HUFFMAN_CODER)
+		method = CODER_METHOD;
+	else if (opt.bwt)
+		method = BWT_METHOD;
+	else if (opt.lzWindow != 0)
+		method = LZ77_METHOD;
+
+	StageTimer headerTimer(opt.stats, Stats::HEADER);
+	unsigned totalHeaderSize = writeExtendedFileHeader(out, method, filterType, stride);
+	headerTimer.stop(totalHeaderSize);
+
+	StageTimer encodeTimer(opt.stats, Stats::ENCODE);
+	unsigned long long fileBodySize;
+	if (method == BWT_METHOD)
+		fileBodySize = encodeBwt(in, out, opt.numOfThreads, filter);
+	else if (method == LZ77_METHOD)
+		fileBodySize = encodeLz77(in, out, opt.lzWindow, filter);
+	else
+		fileBodySize = encodeHuffmanBlocks(in, out, opt.numOfThreads, method, frameSize, opt.coder, filter);
+	encodeTimer.stop(in.getFileSize());
+	delete filter;
+
+	StageTimer patchTimer(opt.stats, Stats::PATCH);
+	out.writeValueAt(BIT_FLAG + METHOD_SIZE, in.getFileSize(), ORIGINAL_SIZE);
+	out.writeValueAt(BIT_FLAG + METHOD_SIZE + ORIGINAL_SIZE, fileBodySize, BODY_SIZE_SIZE);
+	patchTimer.stop(ORIGINAL_SIZE + BODY_SIZE_SIZE);
+
+	// List the new member in the trailer.
+	if (isAppending) {
+		members.push_back(memberOffset);
+		writeTrailer(out, members, memberOffset + totalHeaderSize + fileBodySize);
+	}
+
+	if (opt.stats != NULL) {
+		opt.stats -> originalSize += in.getFileSize();
+		opt.stats -> headerSize += totalHeaderSize;
+		opt.stats -> bodySize += fileBodySize;
+		opt.stats -> numOfWrites += out.getNumOfWrites();
+	}
+
+	out.closeFile();
+
+	cout << src << " -> " << in.getFileSize() << " bytes" << endl;
+	cout << dst << " -> " << totalHeaderSize + fileBodySize << " bytes";
+	if (isAppending)
+		cout << " (member " << members.size() << ")";
+	cout << endl;
+
+	if ((totalHeaderSize + fileBodySize) > in.getFileSize())
+		cout << "*** Size of compressed file > size of source file ***" << endl;
+	return 0;
+} // compressExtended
 
 // Desc: Compression function.
 // Post: Return 0 if success. Otherwise, return -1.
-int compress(const char *src, const char *dst) {
+int compress(const char *src, const char *dst, const Options &opt) {
+	TRACE_SCOPE("compress");
 
 	cout << "Compressing ..." << endl;
 
+	if (opt.lzWindow != 0 || opt.bwt || opt.runs || opt.symbolBits != 8 || opt.frames || opt.coder != HUFFMAN_CODER || 
+		opt.filter != NO_FILTER)
+		return compressExtended(src, dst, opt);
+
 	InBitStream in;		// Create an InBitStream object and open the source file.
 	OutBitStream out;			// Create an OutBitStream object.
 	FrequencyCounter counter;	// Frequency counter object
-	PriorityQueue pq;			// Priority Queue
 
 	// Prepare the source file.
 	bool isSuccessful = in.openFile(src);
@@ -40,47 +281,146 @@ int compress(const char *src, const char *dst) {
 		return -1;
 	}
 
-	counter.createTable(in);
-	cout << src << " -> " << in.getFileSize() << " bytes" << endl;
-	
-	counter.createPriorityQueue(pq);	// Create Priority Queue.
-	HuffmanTree huffTree(pq);			// Create Huffman Tree.
+	// With a static table, the frequency table is already known
+	// and the source file is read only once.
+	unsigned tableId = 0;
+	StageTimer countTimer(opt.stats, Stats::COUNT);
+	if (opt.tableFile != NULL) {
+		if (loadStaticTable(opt.tableFile, counter, tableId) == false)
+			return -1;
+	} else {
+		if (opt.pipeline)
+			countPipelined(in, counter);
+		else
+			counter.createTable(in);
+		cout << src << " -> " << in.getFileSize() << " bytes" << endl;
+	}
+	countTimer.stop(in.getFileSize());
 
-	// huffTree.display();	// Test
+	// Huffman tree and code tables, shared with other files
+	// carrying the same frequency table if a cache is given.
+	StageTimer treeTimer(opt.stats, Stats::TREE);
+	shared_ptr<HuffmanCode> code;
+	if (opt.cache != NULL)
+		code = opt.cache -> get(counter);
+	else
+		code.reset(new HuffmanCode(counter));
+	treeTimer.stop(0);
 
+	// code -> getTree().display();	// Test
+
+	unsigned countedSize = in.getFileSize();
 	in.openFile(src);	// Prepare the source file.
 
-	// Create destination file.
-	isSuccessful = out.openFile(dst);
-	if (isSuccessful == false) {
-		cout << "Error: Cannot create destination file \"" << dst << "\"." << endl;
+	// Create destination file, or add a member to it.
+	vector<unsigned long long> members;
+	unsigned long long memberOffset;
+	bool isAppending;
+	if (openDestination(dst, opt, out, members, memberOffset, isAppending) == false)
 		return -1;
-	}
 
 	// Write file header.
-	unsigned totalHeaderSize = writeFileHeader(out, counter);
+	StageTimer headerTimer(opt.stats, Stats::HEADER);
+	unsigned totalHeaderSize;
+	if (tableId != 0)
+		totalHeaderSize = writeStaticFileHeader(out, tableId);
+	else
+		totalHeaderSize = writeFileHeader(out, counter);
+	headerTimer.stop(totalHeaderSize);
+
+	// With the frequency table in the header, the body size follows from
+	// the code lengths. The destination is then allocated at its final
+	// size and mapped, and the body is encoded straight into it. Other
+	// files than regular ones (a FIFO, a device) are written as streams.
+	MappedFile mapped;
+	if (tableId == 0 && opt.pipeline == false && isAppending == false && MappedFile::isRegularFile(dst)) {
+		out.flush();
+		mapped.map(dst, totalHeaderSize + code -> getEncodedSize(counter.getBitVector()));
+	}
 
 	// Load the data onto output buffer.
 	// And write the compressed data to destination file.
-	unsigned *codeTable = huffTree.getCodeTable();
-	unsigned *codeLengthTable = huffTree.getCodeLengthTable();
-	while (in.loadNextByte() == true) {
-		out.loadNextByte(in.getCharacter(), codeTable, codeLengthTable);
-	}
-	out.sendEOF();	// Write the remaining bits (if any) to file.
+	unsigned *codeTable = code -> getTree().getCodeTable();
+	unsigned *codeLengthTable = code -> getTree().getCodeLengthTable();
+	unsigned fileBodySize = 0;
+
+	// For large sources, the codes of all pairs of characters are
+	// combined up front, so that most steps encode two characters.
+	PairCodeTable *pairs = NULL;
+	if (countedSize >= PAIR_TABLE_THRESHOLD)
+		pairs = new PairCodeTable(codeTable, codeLengthTable);
 
-	unsigned fileBodySize = out.getTotalNumOfBytes();
+	StageTimer encodeTimer(opt.stats, Stats::ENCODE);
+	if (mapped.isMapped()) {
+		char *body = mapped.getData() + totalHeaderSize;
+		fileBodySize = mapped.getSize() - totalHeaderSize;
+		bool isComplete;
+		if (opt.numOfThreads > 1)
+			isComplete = encodeParallelInPlace(in, body, fileBodySize, codeTable, codeLengthTable, pairs, opt.numOfThreads);
+		else
+			isComplete = encodeInPlace(in, body, fileBodySize, codeTable, codeLengthTable, pairs);
+		if (isComplete == false || in.getFileSize() != countedSize) {
+			delete pairs;
+			cout << "Error: \"" << src << "\" has changed while being compressed." << endl;
+
+			// The destination was allocated at its full size; do not
+			// leave it behind.
+			mapped.unmap();
+			out.closeFile();
+			remove(dst);
+			return -1;
+		}
+	} else if (opt.numOfThreads > 1) {
+		encodeParallel(in, out, codeTable, codeLengthTable, pairs, opt.numOfThreads);
+	} else if (opt.pipeline) {
+		encodePipelined(in, out, codeTable, codeLengthTable, pairs);
+	} else {
+		encodeStream(in, out, codeTable, codeLengthTable, pairs);
+	}
+	delete pairs;
+	if (mapped.isMapped() == false) {
+		out.sendEOF();	// Write the remaining bits (if any) to file.
+		fileBodySize = out.getTotalNumOfBytes();
+	}
+	encodeTimer.stop(in.getFileSize());
 
 	// Write the original file size to file.
-	out.writeValueAt(
-		totalHeaderSize - ORIGINAL_SIZE, 
-		in.getFileSize(), 
-		ORIGINAL_SIZE
-	);
+	StageTimer patchTimer(opt.stats, Stats::PATCH);
+	if (mapped.isMapped()) {
+		unsigned originalSize = in.getFileSize();
+		memcpy(mapped.getData() + totalHeaderSize - ORIGINAL_SIZE, &originalSize, ORIGINAL_SIZE);
+		mapped.unmap();
+	} else {
+		out.writeValueAt(
+			totalHeaderSize - ORIGINAL_SIZE, 
+			in.getFileSize(), 
+			ORIGINAL_SIZE
+		);
+	}
+	patchTimer.stop(ORIGINAL_SIZE);
+
+	// List the new member in the trailer.
+	if (isAppending) {
+		members.push_back(memberOffset);
+		writeTrailer(out, members, memberOffset + totalHeaderSize + fileBodySize);
+	}
+
+	if (opt.stats != NULL) {
+		opt.stats -> recordTree(code -> getTree());
+		opt.stats -> originalSize += in.getFileSize();
+		opt.stats -> headerSize += totalHeaderSize;
+		opt.stats -> bodySize += fileBodySize;
+		opt.stats -> numOfWrites += out.getNumOfWrites();
+	}
 
 	out.closeFile();	// Close file.
 
-	cout << dst << " -> " << totalHeaderSize + fileBodySize << " bytes" << endl;
+	if (tableId != 0)
+		cout << src << " -> " << in.getFileSize() << " bytes" << endl;
+	cout << dst << " -> " << totalHeaderSize + fileBodySize << " bytes";
+	if (isAppending)
+		cout << " (member " << members.size() << ")";
+	cout << endl;
 
 	if ((totalHeaderSize + fileBodySize) > in.getFileSize())
 		cout << "*** Size of compressed file > size of source file ***" << endl;
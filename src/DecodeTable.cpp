@@ -0,0 +1,162 @@
+/*
+ * DecodeTable.cpp
+ *
+ * Description: Table-driven Huffman decoder.
+ *              The next LOOKUP_BITS bits of the compressed data index a
+ *              table that gives the decoded character and the length of
+ *              its code directly. Codes longer than LOOKUP_BITS continue
+ *              on the Huffman tree from the node stored in the table.
+ *
+ *
+ */
+
+#include <cstddef>
+#include "DecodeTable.h"
+
+// Desc: Constructor
+DecodeState::DecodeState() {
+	bits = 0;
+	numOfBits = 0;
+	isCorrupted = false;
+} // Constructor
+
+// Desc: Constructor
+//       Walk the tree once for every possible "lookupBits"-bit prefix.
+//  Pre: "tree" outlives the decode table.
+DecodeTable::DecodeTable(const HuffmanTree &tree, unsigned lookupBits) {
+	this -> tree = &tree;
+	this -> lookupBits = lookupBits;
+	entries = new Entry[1 << lookupBits];
+
+	for (unsigned i = 0; i < (1u << lookupBits); i++) {
+		HuffmanTreeNode *ptr = tree.getRoot();
+		unsigned length = 0;
+		unsigned bitMask = 1 << (lookupBits - 1);
+
+		while (ptr != NULL && length < lookupBits) {
+			ptr = tree.walk((i & bitMask) != 0, ptr);
+			bitMask >>= 1;
+			length++;
+			if (ptr != NULL && ptr -> type == char_node)
+				break;
+		}
+
+		if (ptr != NULL && ptr -> type == char_node) {
+			entries[i].node = ptr;
+			entries[i].symbol = ptr -> symbol;
+			entries[i].length = length;
+			entries[i].character = ptr -> character;
+		} else {
+			entries[i].node = ptr;
+			entries[i].symbol = 0;
+			entries[i].length = 0;
+			entries[i].character = 0;
+		}
+	}
+} // Constructor
+
+// Desc: Destructor
+DecodeTable::~DecodeTable() {
+	delete [] entries;
+} // Destructor
+
+// Desc: Decode at most "maxChars" characters from the bytes in
+//       [src, srcEnd) and the pending bits of "state" into "dst".
+// Post: Returns the number of decoded characters. "src" points to the
+//       first byte that has not been read. Decoding stops early when
+//       more input is needed, or when an invalid code is found
+//       ("state.isCorrupted" is set).
+unsigned DecodeTable::decode(const char *&src, const char *srcEnd, char *dst, unsigned maxChars, DecodeState &state) const {
+	const unsigned lookupBits = this -> lookupBits;
+	const unsigned mask = (1 << lookupBits) - 1;
+	unsigned long long bits = state.bits;
+	unsigned numOfBits = state.numOfBits;
+	unsigned count = 0;
+
+	while (count < maxChars) {
+
+		// Refill the pending bits.
+		while (numOfBits <= 56 && src < srcEnd) {
+			bits = (bits << 8) | (unsigned char)(*src++);
+			numOfBits += 8;
+		}
+		if (numOfBits == 0)
+			break;
+
+		// Look up the next "lookupBits" bits (padded with 0's if needed).
+		unsigned index;
+		if (numOfBits >= lookupBits)
+			index = (unsigned)(bits >> (numOfBits - lookupBits)) & mask;
+		else
+			index = (unsigned)(bits << (lookupBits - numOfBits)) & mask;
+		const Entry &entry = entries[index];
+
+		if (entry.length > 0) {		// Short code
+			if (entry.length > numOfBits)
+				break;	// Need more input.
+			dst[count++] = entry.character;
+			numOfBits -= entry.length;
+		} else {		// Long code, continue on the tree.
+			if (entry.node == NULL) {
+				state.isCorrupted = true;
+				break;
+			}
+			if (numOfBits < lookupBits)
+				break;	// Need more input.
+			HuffmanTreeNode *ptr = entry.node;
+			unsigned length = lookupBits;
+			while (ptr != NULL && ptr -> type != char_node && length < numOfBits) {
+				ptr = tree -> walk((bits >> (numOfBits - 1 - length)) & 1, ptr);
+				length++;
+			}
+			if (ptr == NULL) {
+				state.isCorrupted = true;
+				break;
+			}
+			if (ptr -> type != char_node)
+				break;	// Need more input.
+			dst[count++] = ptr -> character;
+			numOfBits -= length;
+		}
+	}
+
+	state.bits = bits;
+	state.numOfBits = numOfBits;
+	return count;
+} // decode
+
+// Desc: Decode one symbol (see HuffmanTreeNode::symbol) from the most
+//       significant of the "numOfBits" bits of "bits" (right aligned).
+//       It works on trees over any alphabet.
+// Post: Returns the length of its code, or 0 if the bits do not start
+//       with a valid code.
+unsigned DecodeTable::decodeSymbol(unsigned long long bits, unsigned numOfBits, unsigned &symbol) const {
+	const unsigned mask = (1 << lookupBits) - 1;
+	unsigned index;
+	if (numOfBits >= lookupBits)
+		index = (unsigned)(bits >> (numOfBits - lookupBits)) & mask;
+	else
+		index = (unsigned)(bits << (lookupBits - numOfBits)) & mask;
+	const Entry &entry = entries[index];
+
+	if (entry.length > 0) {		// Short code
+		if (entry.length > numOfBits)
+			return 0;
+		symbol = entry.symbol;
+		return entry.length;
+	}
+
+	// Long code, continue on the tree.
+	HuffmanTreeNode *ptr = entry.node;
+	unsigned length = lookupBits;
+	while (ptr != NULL && ptr -> type != char_node && length < numOfBits) {
+		ptr = tree -> walk((bits >> (numOfBits - 1 - length)) & 1, ptr);
+		length++;
+	}
+	if (ptr == NULL || ptr -> type != char_node || numOfBits < lookupBits)
+		return 0;
+	symbol = ptr -> symbol;
+	return length;
+} // decodeSymbol
+
+// End of DecodeTable.cpp
@@ -0,0 +1,134 @@
+/*
+ * DecodeTable.h
+ *
+ * Description: Table-driven Huffman decoder.
+ *              The next LOOKUP_BITS bits of the compressed data index a
+ *              table that gives the decoded character and the length of
+ *              its code directly. Codes longer than LOOKUP_BITS continue
+ *              on the Huffman tree from the node stored in the table.
+ *              Large alphabets use a larger table (more lookup bits).
+ *
+ *
+ */
+
+#ifndef DECODETABLE_H
+#define DECODETABLE_H
+
+#include "HuffmanTree.h"
+#include "HuffmanTreeNode.h"
+
+// Desc: Bits that have been read but not decoded yet.
+//       It allows decoding to continue across several input blocks.
+class DecodeState {
+public:
+	unsigned long long bits;	// Pending bits (right aligned).
+	unsigned numOfBits;			// Number of pending bits.
+	bool isCorrupted;			// An invalid code has been found.
+
+	// Constructor
+	DecodeState();
+}; // DecodeState
+
+class DecodeTable {
+private:
+	// Desc: One entry of the lookup table.
+	//       length > 0: the code of "character" ("symbol") is "length"
+	//                   bits long.
+	//       length == 0: the code is longer than "lookupBits" bits, continue
+	//                    from "node". NULL means the bits form no valid code.
+	struct Entry {
+		HuffmanTreeNode *node;
+		unsigned symbol;
+		unsigned char length;
+		char character;
+	};
+
+	Entry *entries;
+	const HuffmanTree *tree;
+	unsigned lookupBits;	// Number of bits used to index the table.
+
+	// Copying a table is not allowed.
+	DecodeTable(const DecodeTable &);
+	DecodeTable &operator = (const DecodeTable &);
+
+public:
+	// Number of bits used to index the lookup table by default.
+	static const unsigned LOOKUP_BITS = 11;
+
+	// Constructor and destructor
+	//  Pre: "tree" outlives the decode table, and "lookupBits" is at
+	//       most 16.
+	DecodeTable(const HuffmanTree &tree, unsigned lookupBits = LOOKUP_BITS);
+	~DecodeTable();
+
+	// Desc: Decode at most "maxChars" characters from the bytes in
+	//       [src, srcEnd) and the pending bits of "state" into "dst".
+	// Post: Returns the number of decoded characters. "src" points to the
+	//       first byte that has not been read. Decoding stops early when
+	//       more input is needed, or when an invalid code is found
+	//       ("state.isCorrupted" is set).
+	unsigned decode(const char *&src, const char *srcEnd, char *dst, unsigned maxChars, DecodeState &state) const;
+
+	// Desc: Decode one symbol (see HuffmanTreeNode::symbol) from the most
+	//       significant of the "numOfBits" bits of "bits" (right aligned).
+	//       It works on trees over any alphabet.
+	// Post: Returns the length of its code, or 0 if the bits do not start
+	//       with a valid code.
+	unsigned decodeSymbol(unsigned long long bits, unsigned numOfBits, unsigned &symbol) const;
+
+}; // DecodeTable
+
+// Desc: Reads codes and plain values from coded data held in memory,
+//       e.g. the blocks of the LZ77 method.
+class BitReader {
+private:
+	const char *src;
+	const char *srcEnd;
+	unsigned long long bits;	// Pending bits (right aligned).
+	unsigned numOfBits;			// Number of pending bits.
+
+public:
+	// Constructor
+	//       The data is the bytes in [src, srcEnd).
+	BitReader(const char *src, const char *srcEnd) : src(src), srcEnd(srcEnd), bits(0), numOfBits(0) {}
+
+	// Desc: Read more bytes, so that at least 57 bits are
+	//       pending, unless the data ends.
+	void refill() {
+		while (numOfBits <= 56 && src < srcEnd) {
+			bits = (bits << 8) | (unsigned char)(*src++);
+			numOfBits += 8;
+		}
+	}
+
+	// Desc: Decode one symbol with "table".
+	// Post: Return false if the bits are not a valid code.
+	bool readSymbol(const DecodeTable &table, unsigned &symbol) {
+		refill();
+		unsigned length = table.decodeSymbol(bits, numOfBits, symbol);
+		numOfBits -= length;
+		return length != 0;
+	}
+
+	// Desc: Read a value of "count" bits.
+	//  Pre: count <= 24.
+	// Post: Return false if the data ends.
+	bool readBits(unsigned count, unsigned &value) {
+		// Up to 64 bits may be pending, and a shift by 64 is undefined.
+		if (count == 0) {
+			value = 0;
+			return true;
+		}
+		refill();
+		if (count > numOfBits)
+			return false;
+		numOfBits -= count;
+		value = (unsigned)(bits >> numOfBits) & ((1u << count) - 1);
+		return true;
+	}
+
+}; // BitReader
+
+#endif
+
+// End of DecodeTable.h
@@ -8,109 +8,498 @@
  */
 
 #include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
 #include "InBitStream.h"
 #include "OutBitStream.h"
-#include "FrequencyCounter.h"
-#include "PriorityQueue.h"
-#include "HuffmanTree.h"
-#include "HuffmanTreeNode.h"
+#include "DecodeTable.h"
+#include "CodeTableCache.h"
+#include "StreamDecoder.h"
+#include "Options.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "Trailer.h"
+#include "MappedFile.h"
+#include "Lz77.h"
+#include "Bwt.h"
+#include "HuffmanBlocks.h"
+#include "Filter.h"
 #include "HeaderFormat.h"
 
 using namespace std;
 
-// Desc: Read the needed information from the header of 
-//       the compressed file.
+// Desc: Parse an extended header.
 //       Implemented in "FileHeaderHandler.cpp".
-int readFileHeader(InBitStream &, FrequencyCounter &);
+int parseExtendedFileHeader(const char *, unsigned, char &, unsigned &, unsigned long long &, char &, unsigned &);
 
+// Desc: Pipelined decoding.
+//       Implemented in "Pipeline.cpp".
+bool decodePipelined(InBitStream &, OutBitStream &, const DecodeTable &, unsigned);
 
-// Desc: Decompression function.
+// Desc: Multi-threaded speculative decoding.
+//       Implemented in "ParallelDecode.cpp".
+bool decodeParallel(InBitStream &, OutBitStream &, const DecodeTable &, unsigned, unsigned);
+bool decodeParallelInPlace(InBitStream &, char *, const DecodeTable &, unsigned, unsigned);
+
+// Size of the input and output buffers used for decoding, in bytes.
+// Together with the header, they are all the memory the decoder uses.
+static const unsigned DECODE_BLOCK_SIZE = 64 * 1024;
+
+// Desc: Return true if a body of "bodySize" bytes coded with "method"
+//       (0 for a plain header) can decode to "originalSize" bytes. The
+//       body starts at "bodyStart" and ends by "limit". A bodySize of 0
+//       with a plain header means that the body may take up to "limit".
+//       It is checked before the destination is allocated at the
+//       original size, which a corrupted header could make huge.
+static bool isSizeValid(unsigned originalSize, unsigned long long bodyStart, unsigned long long bodySize, 
+	unsigned long long limit, char method) {
+	if (bodyStart > limit || bodySize > limit - bodyStart)
+		return false;
+	if (method == 0) {
+		// Each character takes at least one bit.
+		if (bodySize == 0)
+			bodySize = limit - bodyStart;
+		return originalSize <= 8 * bodySize;
+	}
+	return originalSize <= bodySize / MIN_BLOCK_HEADER_SIZE * MAX_BLOCK_SIZE;
+} // isSizeValid
+
+// Desc: Prepare the destination of a member that decompresses to
+//       "dataEnd" bytes in total. If "dst" is not NULL, the destination
+//       file "dst" is created and mapped (unless --pipeline is given or
+//       it is not a regular file, e.g. a FIFO), otherwise the mapping
+//       (if any) is extended.
+// Post: Return false if it fails (the error is printed).
+static bool prepareDestination(const char *dst, OutBitStream &out, MappedFile &mapped, 
+	unsigned long long dataEnd, const Options &opt) {
+	if (dst != NULL) {
+		if ((opt.pipeline || MappedFile::isRegularFile(dst) == false || mapped.map(dst, dataEnd) == false) &&
+			out.openFile(dst) == false) {
+			cout << "Error: Cannot create destination file \"" << dst << "\"." << endl;
+			return false;
+		}
+	} else if (mapped.isMapped() && mapped.getSize() < dataEnd) {
+		if (mapped.resize(dataEnd) == false) {
+			cout << "Error: Cannot extend the destination file." << endl;
+			return false;
+		}
+	}
+	return true;
+} // prepareDestination
+
+// Desc: Decode a member with an extended header (see "HeaderFormat.h"),
+//       whose first "size" bytes are in "header", and which ends by
+//       "limit". The other arguments are those of decompressMember().
 // Post: Return 0 if success. Otherwise, return -1.
-int decompress(const char *src, const char *dst) {
+static int decompressExtendedMember(const char *src, InBitStream &in, const char *header, unsigned size, 
+	unsigned long long offset, unsigned long long limit, const char *dst, OutBitStream &out, MappedFile &mapped, 
+	unsigned long long &position, const Options &opt, unsigned long long &memberEnd) {
 
-	cout << "Decompressing ... " << endl;
+	StageTimer headerTimer(opt.stats, Stats::HEADER);
+	char method, filterType;
+	unsigned originalSize, stride;
+	unsigned long long bodySize;
+	unsigned headerSize = parseExtendedFileHeader(header, size, method, originalSize, bodySize, filterType, stride);
+	headerTimer.stop(headerSize);
+	if (headerSize == 0 || method < LZ77_METHOD || method > CODER_METHOD ||
+		filterType < NO_FILTER || filterType > XOR_FILTER || stride < 1 || stride > MAX_FILTER_STRIDE ||
+		isSizeValid(originalSize, offset + headerSize, bodySize, limit, method) == false) {
+		cout << "Error: \"" << src << "\" is corrupted." << endl;
+		return -1;
+	}
+
+	unsigned long long outEnd = position + originalSize;
+	if (prepareDestination(dst, out, mapped, outEnd, opt) == false)
+		return -1;
+
+	StageTimer decodeTimer(opt.stats, Stats::DECODE);
+	in.gotoPos(offset + headerSize);
+	char *target = mapped.isMapped() ? mapped.getData() + position : NULL;
+	Filter *filter = filterType != NO_FILTER ? new Filter(filterType, stride) : NULL;
+	bool isComplete;
+	if (method == BWT_METHOD)
+		isComplete = decodeBwt(in, bodySize, originalSize, target, out, opt.numOfThreads, filter);
+	else if (method == LZ77_METHOD)
+		isComplete = decodeLz77(in, bodySize, originalSize, target, out, filter);
+	else
+		isComplete = decodeHuffmanBlocks(in, bodySize, originalSize, target, out, opt.numOfThreads, method, filter);
+
+	// Undo the filter of the decoded data.
+	if (filter != NULL && isComplete && target != NULL)
+		filter -> revert(target, originalSize);
+	else if (filter != NULL && isComplete)
+		filter -> flush(out);
+	delete filter;
+	decodeTimer.stop(originalSize);
+	position = outEnd;
+	memberEnd = offset + headerSize + bodySize;
+
+	if (opt.stats != NULL) {
+		opt.stats -> originalSize += originalSize;
+		opt.stats -> headerSize += headerSize;
+		opt.stats -> bodySize += bodySize;
+	}
+
+	if (isComplete == false) {
+		cout << "Error: \"" << src << "\" is corrupted." << endl;
+		return -1;
+	}
+	return 0;
+} // decompressExtendedMember
+
+// Desc: Decode the member of "src" that starts at "offset". "end" is where
+//       the member ends if it is indexed, 0 if unknown, and "dataEnd" is
+//       where the members of "src" end. The decompressed
+//       data is written at "position" of the destination if "mapped" is
+//       mapped (which is extended if needed), or appended to "out".
+//       If "dst" is not NULL, the destination file "dst" is created once
+//       the header is read. It is mapped unless --pipeline is given.
+// Post: Return 0 if success. Otherwise, return -1. "memberEnd" is the
+//       offset right after the member, and "position" is moved past the
+//       decompressed data.
+static int decompressMember(const char *src, unsigned long long offset, unsigned long long end, 
+	unsigned long long dataEnd, const char *dst, OutBitStream &out, MappedFile &mapped, unsigned long long &position, 
+	const Options &opt, unsigned long long &memberEnd) {
 
 	InBitStream in;				// Create an InBitStream object and open the source file.
-	OutBitStream out;			// Create an OutBitStream object.
-	FrequencyCounter counter;	// Frequency counter object
-	PriorityQueue pq;			// Priority Queue
+	StreamDecoder decoder(opt);	// Resumable decoder
 
 	bool isSuccessful = in.openFile(src);
 	if (isSuccessful == false) {
 		cout << "Error: Cannot open file \"" << src << "\"." << endl;
 		return -1;
 	}
+	in.gotoPos(offset);
 
-	// Read file header.
-	unsigned totalHeaderSize = readFileHeader(in, counter);
-
-	counter.createPriorityQueue(pq);	// Create Priority Queue.
-	HuffmanTree huffTree(pq);			// Create Huffman Tree.
+	char *inBuffer = new char[DECODE_BLOCK_SIZE];
+	char *outBuffer = new char[DECODE_BLOCK_SIZE];
+	unsigned consumed, produced;
 
-	// Read the file-body size.
-	unsigned originalFileSize = in.readValue(ORIGINAL_SIZE);
-	totalHeaderSize += ORIGINAL_SIZE;
+	// Read file header.
+	// A header is always shorter than one input buffer.
+	StageTimer headerTimer(opt.stats, Stats::HEADER);
+	unsigned inSize = in.readBlock(inBuffer, DECODE_BLOCK_SIZE);
+	if (inSize > 0 && (inBuffer[0] & ~FILTER_FLAG) == EXTENDED_FLAG) {
+		int result = decompressExtendedMember(src, in, inBuffer, inSize, offset, end != 0 ? end : dataEnd, 
+			dst, out, mapped, position, opt, memberEnd);
+		delete [] inBuffer;
+		delete [] outBuffer;
+		return result;
+	}
+	StreamDecoder::Status status = decoder.decode(inBuffer, inSize, consumed, outBuffer, 0, produced);
+	headerTimer.stop(decoder.getHeaderSize());
 
-	in.openFile(src);	// Prepare the source file.
+	if (status == StreamDecoder::MISSING_TABLE) {
+		cout << "Error: \"" << src << "\" requires the static table " << decoder.getTableId();
+		if (opt.tableFile != NULL)
+			cout << ", which \"" << opt.tableFile << "\" is not";
+		cout << "." << endl;
+	} else if (decoder.hasHeader() == false) {
+		cout << "Error: \"" << src << "\" is corrupted." << endl;
+	} else if (isSizeValid(decoder.getOriginalSize(), offset + decoder.getHeaderSize(), 
+		decoder.getTableId() == 0 ? decoder.getBodySize() : 0, end != 0 ? end : dataEnd, 0) == false) {
+		cout << "Error: \"" << src << "\" is corrupted." << endl;
+		isSuccessful = false;
+	}
 
-	// Create destination file.
-	isSuccessful = out.openFile(dst);
-	if (isSuccessful == false) {
-		cout << "Error: Cannot create destination file \"" << dst << "\"." << endl;
+	// Create destination file. The decompressed size is known from the
+	// header, so the file is allocated and mapped at once, and extended
+	// for every other member.
+	unsigned long long outEnd = position + decoder.getOriginalSize();
+	if (decoder.hasHeader() && isSuccessful)
+		isSuccessful = prepareDestination(dst, out, mapped, outEnd, opt);
+	if (decoder.hasHeader() == false || isSuccessful == false) {
+		delete [] inBuffer;
+		delete [] outBuffer;
 		return -1;
 	}
 
-	// Move the read pointer to the beginning of file-body.
-	in.gotoPos(totalHeaderSize);
+	// The end of the member must be known beforehand to decode with
+	// threads, since they read ahead. Without a frequency table in the
+	// header, only the index tells it.
+	if (decoder.getTableId() == 0)
+		end = offset + decoder.getHeaderSize() + decoder.getBodySize();
+	bool isThreaded = (opt.numOfThreads > 1 || opt.pipeline) && end != 0;
 
-	unsigned processedChar = 0;
-	HuffmanTreeNode *ptr = huffTree.getRoot();	// Used for search the code.
+	bool isComplete;
+	char *target = mapped.isMapped() ? mapped.getData() + position : NULL;
+	const DecodeTable &decodeTable = decoder.getCode() -> getDecodeTable();
+	StageTimer decodeTimer(opt.stats, Stats::DECODE);
+	if (isThreaded) {
 
-	while (processedChar < originalFileSize) {
-		if (in.loadNextByte() == true) {
-			char buffer = 0;		// "0000 0000"
-			short bitMask = 0x80;	// "1000 0000"
-			buffer = in.getCharacter();	// Read one byte from the file.
+		// Move the read pointer to the beginning of file-body.
+		in.openFile(src);
+		in.gotoPos(offset + decoder.getHeaderSize());
 
-			// 8 bits in one byte.
-			for (int i = 0; i < 8; i++) {
-				// Get the direction.
-				char direction = buffer & bitMask;
+		if (opt.numOfThreads > 1 && target != NULL)
+			isComplete = decodeParallelInPlace(in, target, decodeTable, decoder.getOriginalSize(), opt.numOfThreads);
+		else if (opt.numOfThreads > 1)
+			isComplete = decodeParallel(in, out, decodeTable, decoder.getOriginalSize(), opt.numOfThreads);
+		else
+			isComplete = decodePipelined(in, out, decodeTable, decoder.getOriginalSize());
+		memberEnd = end;
+	} else {
+		TRACE_SCOPE("decode");
 
-				// Move one step on the Huffman tree.
-				ptr = huffTree.walk(direction, ptr);
+		// Decode the buffered input, then read more until finished.
+		// With a mapped destination, the characters are decoded in place.
+		unsigned written = 0;
+		memberEnd = offset + consumed;
+		const char *pos = inBuffer + consumed;
+		unsigned available = inSize - consumed;
+		while (status != StreamDecoder::FINISHED && status != StreamDecoder::CORRUPTED) {
+			if (status == StreamDecoder::NEED_INPUT && available == 0) {
+				available = in.readBlock(inBuffer, DECODE_BLOCK_SIZE);
+				pos = inBuffer;
+				if (available == 0)
+					break;	// The data ends too early.
+			}
+			if (target != NULL) {
+				status = decoder.decode(pos, available, consumed, target + written, decoder.getOriginalSize() - written, produced);
+				written += produced;
+			} else {
+				status = decoder.decode(pos, available, consumed, outBuffer, DECODE_BLOCK_SIZE, produced);
+				out.writeBlock(outBuffer, produced);
+			}
+			pos += consumed;
+			available -= consumed;
+			memberEnd += consumed;
+		}
+		isComplete = (status == StreamDecoder::FINISHED);
+	}
 
-				// Untill it reach NULL (Might happen in empty file), 
-				// or a character node.
-				if (ptr != NULL && ptr -> type == char_node) {
+	delete [] inBuffer;
+	delete [] outBuffer;
+	decodeTimer.stop(decoder.getOriginalSize());
+	position = outEnd;
 
-					// Write the corresponding character to the destination file.
-					out.writeByte(ptr -> character);
-					ptr = huffTree.getRoot();	// Reset the pointer
-					processedChar++;
-					if (processedChar >= originalFileSize) {
+	if (opt.stats != NULL) {
+		opt.stats -> recordTree(decoder.getCode() -> getTree());
+		opt.stats -> originalSize += decoder.getOriginalSize();
+		opt.stats -> headerSize += decoder.getHeaderSize();
+		opt.stats -> bodySize += memberEnd - offset - decoder.getHeaderSize();
+	}
 
-						// It may occur when the last byte of file
-						// has some padding 0's.
-						break;
-					}
-				}
-				bitMask >>= 1;
-			}
-		} else {
+	if (isComplete == false) {
+		cout << "Error: \"" << src << "\" is corrupted." << endl;
+		return -1;
+	}
+	return 0;
+} // decompressMember
+
+// Desc: Decode the members of "src" in "members[first]", "members[first
+//       + numOfThreads]", ... Each one is written at its own position of
+//       "dst", given by "outOffsets": in "mapped" if the destination is
+//       mapped (at its final size), otherwise through a stream of its own.
+static void decodeMembers(const char *src, const char *dst, MappedFile *mapped, 
+	const vector<MemberInfo> *members, const vector<unsigned long long> *outOffsets, 
+	unsigned long long dataEnd, unsigned first, unsigned numOfThreads, const Options *opt, 
+	vector<int> *statuses, vector<unsigned> *numOfWrites) {
+
+	for (unsigned i = first; i < members -> size(); i += numOfThreads) {
+		TRACE_SCOPE_ARG("decode member", i);
+		unsigned long long end = (i + 1 < members -> size()) ? (*members)[i + 1].offset : dataEnd;
+		unsigned long long position = (*outOffsets)[i];
+		unsigned long long memberEnd;
+		OutBitStream out;
+		if (mapped -> isMapped() == false && out.openFileAt(dst, position) == false) {
+			cout << "Error: Cannot create destination file \"" << dst << "\"." << endl;
+			(*statuses)[i] = -1;
+			continue;
+		}
+		(*statuses)[i] = decompressMember(src, (*members)[i].offset, end, dataEnd, NULL, out, *mapped, position, *opt, memberEnd);
+		out.closeFile();
+		(*numOfWrites)[i] = out.getNumOfWrites();
+	}
+} // decodeMembers
 
+// Desc: Decode the indexed members of "src" with "opt.numOfThreads"
+//       threads, one member per thread at a time. The position of each
+//       member in "dst" follows from the original sizes in the headers.
+//  Pre: "offsets" lists every member, the first one at offset 0.
+// Post: Return 0 if success. Otherwise, return -1.
+static int decompressMembersParallel(const char *src, const char *dst, 
+	const vector<unsigned long long> &offsets, unsigned long long dataEnd, const Options &opt) {
+
+	// Read the headers.
+	StageTimer headerTimer(opt.stats, Stats::HEADER);
+	vector<MemberInfo> members(offsets.size());
+	vector<unsigned long long> outOffsets(offsets.size() + 1, 0);
+	unsigned long long totalHeaderSize = 0;
+	for (unsigned i = 0; i < offsets.size(); i++) {
+		unsigned long long end = (i + 1 < offsets.size()) ? offsets[i + 1] : dataEnd;
+		if (readMemberHeader(src, offsets[i], members[i]) == false || 
+			isSizeValid(members[i].originalSize, offsets[i] + members[i].headerSize, 
+				members[i].tableId == 0 ? members[i].bodySize : 0, end, members[i].method) == false) {
 			cout << "Error: \"" << src << "\" is corrupted." << endl;
-			out.closeFile();
 			return -1;
 		}
+		outOffsets[i + 1] = outOffsets[i] + members[i].originalSize;
+		totalHeaderSize += members[i].headerSize;
+	}
+	headerTimer.stop(totalHeaderSize);
+
+	// Create destination file at its final size. The members are
+	// written in place, into disjoint parts of the file.
+	MappedFile mapped;
+	if (MappedFile::isRegularFile(dst) == false || mapped.map(dst, outOffsets.back()) == false) {
+		OutBitStream out;
+		if (out.openFile(dst) == false) {
+			cout << "Error: Cannot create destination file \"" << dst << "\"." << endl;
+			return -1;
+		}
+		out.closeFile();
 	}
 
-	// Close the destination file.
-	out.closeFile();
+	// Each member is decoded by a single thread.
+	Options memberOpt = opt;
+	memberOpt.numOfThreads = 1;
+	memberOpt.pipeline = false;
+	memberOpt.stats = NULL;
+
+	unsigned numOfThreads = opt.numOfThreads < members.size() ? opt.numOfThreads : members.size();
+	vector<int> statuses(members.size(), 0);
+	vector<unsigned> numOfWrites(members.size(), 0);
+	vector<thread> workers;
+	StageTimer decodeTimer(opt.stats, Stats::DECODE);
+	for (unsigned i = 0; i < numOfThreads; i++) {
+		workers.push_back(thread(
+			decodeMembers, src, dst, &mapped, &members, &outOffsets, dataEnd, 
+			i, numOfThreads, &memberOpt, &statuses, &numOfWrites
+		));
+	}
+	for (unsigned i = 0; i < numOfThreads; i++)
+		workers[i].join();
+	mapped.unmap();
+	decodeTimer.stop(outOffsets.back());
+
+	int status = 0;
+	for (unsigned i = 0; i < members.size(); i++) {
+		if (statuses[i] == -1)
+			status = -1;
+		if (opt.stats != NULL) {
+			unsigned long long end = (i + 1 < members.size()) ? members[i + 1].offset : dataEnd;
+			opt.stats -> originalSize += members[i].originalSize;
+			opt.stats -> headerSize += members[i].headerSize;
+			opt.stats -> bodySize += end - members[i].offset - members[i].headerSize;
+			opt.stats -> numOfWrites += numOfWrites[i];
+		}
+	}
+
+	// Do not leave a partly decoded destination behind.
+	if (status == -1 && MappedFile::isRegularFile(dst))
+		remove(dst);
+	return status;
+} // decompressMembersParallel
+
+// Desc: Decompression function.
+//       A file may hold several members, appended with --append or
+//       joined with "cat". They are decoded in order into one destination
+//       file, or in parallel with -j if the trailer indexes all of them.
+// Post: Return 0 if success. Otherwise, return -1.
+int decompress(const char *src, const char *dst, const Options &opt) {
+	TRACE_SCOPE("decompress");
+
+	cout << "Decompressing ... " << endl;
+
+	vector<unsigned long long> indexed;
+	unsigned long long dataEnd;
+	if (readTrailer(src, indexed, dataEnd) == false) {
+		cout << "Error: Cannot open file \"" << src << "\"." << endl;
+		return -1;
+	}
+	if (dataEnd == 0) {
+		cout << "Error: \"" << src << "\" is corrupted." << endl;
+		return -1;
+	}
+
+	int status = 0;
+	if (opt.numOfThreads > 1 && indexed.size() > 1 && indexed[0] == 0) {
+		status = decompressMembersParallel(src, dst, indexed, dataEnd, opt);
+	} else {
+		OutBitStream out;	// Create an OutBitStream object.
+		MappedFile mapped;	// Or the mapped destination.
+		unsigned long long position = 0;	// Size of the decompressed data.
+		unsigned long long pos = 0;
+		unsigned next = 0;	// First indexed member not before "pos".
+		bool isFirst = true;
+		while (pos < dataEnd && status == 0) {
+			// Skip the trailers of files joined with "cat".
+			unsigned trailerSize = isFirst ? 0 : getTrailerSizeAt(src, pos);
+			if (trailerSize != 0) {
+				pos += trailerSize;
+				continue;
+			}
+
+			unsigned long long end = 0;		// Not indexed.
+			while (next < indexed.size() && indexed[next] < pos)
+				next++;
+			if (next < indexed.size() && indexed[next] == pos)
+				end = (next + 1 < indexed.size()) ? indexed[next + 1] : dataEnd;
+
+			status = decompressMember(src, pos, end, dataEnd, isFirst ? dst : NULL, out, mapped, position, opt, pos);
+			isFirst = false;
+		}
+
+		if (opt.stats != NULL)
+			opt.stats -> numOfWrites += out.getNumOfWrites();
+
+		// Close the destination file. If it was created, do not leave
+		// it behind partly decoded.
+		bool isCreated = out.isOpen() || mapped.isMapped();
+		out.closeFile();
+		mapped.unmap();
+		if (status == -1 && isCreated && MappedFile::isRegularFile(dst))
+			remove(dst);
+	}
+	if (status == -1)
+		return -1;
 
 	cout << "Completed: " << src << " -> " << dst << endl;
 	return 0;
 	
 } // deconpress
 
+// Desc: Decompress every file listed in "listFile" (one name per line)
+//       into the directory "dstDir". A trailing ".huff" is removed from
+//       the names of the decompressed files. Files carrying an identical
+//       frequency table share their code tables through a cache.
+// Post: Return 0 if all files are decompressed. Otherwise, return -1.
+int decompressBatch(const char *listFile, const char *dstDir, const Options &opt) {
+	ifstream list(listFile);
+	if (!list.is_open()) {
+		cout << "Error: Cannot open file \"" << listFile << "\"." << endl;
+		return -1;
+	}
+
+	CodeTableCache cache;
+	Options batchOpt = opt;
+	batchOpt.cache = &cache;
+
+	int status = 0;
+	unsigned numOfFiles = 0;
+	string src;
+	while (getline(list, src)) {
+		if (src.empty())
+			continue;
+
+		// Destination: [dstDir]/[base name without ".huff"]
+		string name = src.substr(src.find_last_of('/') + 1);
+		if (name.size() > 5 && name.compare(name.size() - 5, 5, ".huff") == 0)
+			name.erase(name.size() - 5);
+		string dst = string(dstDir) + "/" + name;
+
+		if (decompress(src.c_str(), dst.c_str(), batchOpt) == -1)
+			status = -1;
+		numOfFiles++;
+	}
+
+	cout << numOfFiles << " files, code table cache: " << cache.getHits() << " hits, " 
+		<< cache.getMisses() << " misses." << endl;
+	return status;
+} // decompressBatch
+
 // End of Decompress.cpp
@@ -0,0 +1,91 @@
+/*
+ * EntropyCoder.cpp
+ *
+ * Description: The entropy coders of the blocks, behind one interface.
+ *
+ *
+ */
+
+#include "EntropyCoder.h"
+#include "BitBuffer.h"
+#include "HeaderFormat.h"
+
+using namespace std;
+
+// Desc: Constructor
+//       Build the coder of "type" from the weights of "numOfSymbols"
+//       symbols.
+EntropyCoder::EntropyCoder(char type, const unsigned *weights, unsigned numOfSymbols) {
+	this -> type = type;
+	this -> numOfSymbols = numOfSymbols;
+	tree = NULL;
+	table = NULL;
+	tans = NULL;
+	if (type == TANS_CODER) {
+		tans = new Tans(weights, numOfSymbols);
+	} else {
+		tree = new HuffmanTree(weights, numOfSymbols);
+		table = new DecodeTable(*tree);
+	}
+} // Constructor
+
+// Desc: Destructor
+EntropyCoder::~EntropyCoder() {
+	delete table;
+	delete tree;
+	delete tans;
+} // Destructor
+
+// Desc: Return the number of bits encode() writes for the symbols
+//       counted in "weights".
+unsigned long long EntropyCoder::getCodedBits(const unsigned *weights) const {
+	if (type == TANS_CODER)
+		return tans -> getCodedBits(weights);
+	const unsigned *codeLengthTable = tree -> getCodeLengthTable();
+	unsigned long long bits = 0;
+	for (unsigned i = 0; i < numOfSymbols; i++)
+		bits += (unsigned long long)weights[i] * codeLengthTable[i];
+	return bits;
+} // getCodedBits
+
+// Desc: Code the "size" symbols of "src" into "dst".
+// Post: Returns the number of bytes written.
+unsigned EntropyCoder::encode(const unsigned char *src, unsigned size, char *dst) const {
+	if (type == TANS_CODER)
+		return tans -> encode(src, size, dst);
+	const unsigned *codeTable = tree -> getCodeTable();
+	const unsigned *codeLengthTable = tree -> getCodeLengthTable();
+	BitBuffer buffer;
+	buffer.setDestination(dst);
+	for (unsigned i = 0; i < size; i++)
+		buffer.writeCode(codeTable[src[i]], codeLengthTable[src[i]]);
+	buffer.flush();
+	return buffer.getLength();
+} // encode
+
+// Desc: Decode "size" symbols from the "srcSize" bytes of "src" into "dst".
+// Post: Return false if the data is not valid.
+bool EntropyCoder::decode(const char *src, unsigned srcSize, char *dst, unsigned size) const {
+	if (type == TANS_CODER)
+		return tans -> decode(src, srcSize, dst, size);
+	BitReader reader(src, src + srcSize);
+	unsigned symbol;
+	for (unsigned i = 0; i < size; i++) {
+		if (reader.readSymbol(*table, symbol) == false)
+			return false;
+		dst[i] = symbol;
+	}
+	return true;
+} // decode
+
+// Desc: Return the type of the coder that spends the fewest bits on the
+//       symbols counted in "weights".
+char chooseCoder(const unsigned *weights, unsigned numOfSymbols) {
+	EntropyCoder huffman(HUFFMAN_CODER, weights, numOfSymbols);
+	EntropyCoder tans(TANS_CODER, weights, numOfSymbols);
+	if (tans.getCodedBits(weights) < huffman.getCodedBits(weights))
+		return TANS_CODER;
+	return HUFFMAN_CODER;
+} // chooseCoder
+
+// End of EntropyCoder.cpp
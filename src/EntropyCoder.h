@@ -0,0 +1,68 @@
+/*
+ * EntropyCoder.h
+ *
+ * Description: The entropy coders of the blocks, behind one interface.
+ *              A coder is built from the weights of the symbols, which are
+ *              stored the same way for every coder, and codes or decodes
+ *              a block of symbols in memory. Huffman codes are fast and
+ *              spend a whole number of bits per symbol; tANS (see
+ *              "Tans.h") spends fractions of a bit, which pays off on
+ *              skewed data, where the most common symbol is far more
+ *              likely than one half.
+ *
+ *
+ */
+
+#ifndef ENTROPYCODER_H
+#define ENTROPYCODER_H
+
+#include "HuffmanTree.h"
+#include "DecodeTable.h"
+#include "Tans.h"
+
+// The coder types are HUFFMAN_CODER and TANS_CODER (see "HeaderFormat.h").
+class EntropyCoder {
+private:
+	char type;			// HUFFMAN_CODER or TANS_CODER
+	unsigned numOfSymbols;
+	HuffmanTree *tree;
+	DecodeTable *table;
+	Tans *tans;
+
+	// Copying a coder is not allowed.
+	EntropyCoder(const EntropyCoder &);
+	EntropyCoder &operator = (const EntropyCoder &);
+
+public:
+	// Constructor and destructor
+	//       Build the coder of "type" from the weights of "numOfSymbols"
+	//       symbols.
+	//  Pre: numOfSymbols <= 256, and at least one weight is not 0.
+	EntropyCoder(char type, const unsigned *weights, unsigned numOfSymbols);
+	~EntropyCoder();
+
+	// Desc: Return the number of bits encode() writes for the symbols
+	//       counted in "weights" (the ones of the constructor).
+	unsigned long long getCodedBits(const unsigned *weights) const;
+
+	// Desc: Code the "size" symbols of "src" into "dst".
+	//  Pre: The symbols of "src" have a weight, and "dst" has room for
+	//       4 * size + 8 bytes.
+	// Post: Returns the number of bytes written.
+	unsigned encode(const unsigned char *src, unsigned size, char *dst) const;
+
+	// Desc: Decode "size" symbols from the "srcSize" bytes of "src"
+	//       into "dst".
+	// Post: Return false if the data is not valid.
+	bool decode(const char *src, unsigned srcSize, char *dst, unsigned size) const;
+
+}; // EntropyCoder
+
+// Desc: Return the type of the coder that spends the fewest bits on the
+//       symbols counted in "weights".
+//  Pre: Same as the constructor of EntropyCoder.
+char chooseCoder(const unsigned *weights, unsigned numOfSymbols);
+
+#endif
+
+// End of EntropyCoder.h
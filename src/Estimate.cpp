@@ -0,0 +1,129 @@
+/*
+ * Estimate.cpp
+ *
+ * Description: Predict the size of the compressed file without
+ *              encoding or writing anything. The body size follows from
+ *              the frequency table and the code lengths, and the header
+ *              size from the frequency table alone, so one counting
+ *              pass (or a sample of the file) is enough.
+ *
+ *
+ */
+
+#include <iostream>
+#include "Estimate.h"
+#include "InBitStream.h"
+#include "FrequencyCounter.h"
+#include "CodeTableCache.h"
+#include "HeaderFormat.h"
+
+using namespace std;
+
+// Desc: Size of the bit flag and the frequency table in the header.
+//       Implemented in "FileHeaderHandler.cpp".
+int frequencyTableSize(FrequencyCounter &);
+
+// Desc: Load a pre-trained static table.
+//       Implemented in "StaticTable.cpp".
+bool loadStaticTable(const char *, FrequencyCounter &, unsigned &);
+
+// Size of the blocks the sample is made of, in bytes.
+static const unsigned SAMPLE_BLOCK_SIZE = 64 * 1024;
+
+// Desc: Default constructor
+SizeEstimate::SizeEstimate() {
+	originalSize = 0;
+	sampledSize = 0;
+	headerSize = 0;
+	bodySize = 0;
+	compressedSize = 0;
+	ratio = 0;
+	isExact = false;
+} // Default constructor
+
+// Desc: Predict the compressed size of "src" when compressed with "opt".
+//       Only "opt.samplePercent" percent of the file is counted (evenly
+//       spread blocks); the estimate is exact when it is 100.
+// Post: Return true if success. Otherwise, return false.
+bool estimateCompressedSize(const char *src, const Options &opt, SizeEstimate &estimate) {
+	ifstream file(src, ios::in | ios::binary | ios::ate);
+	if (!file.is_open()) {
+		cout << "Error: Cannot open file \"" << src << "\"." << endl;
+		return false;
+	}
+	estimate = SizeEstimate();
+	estimate.originalSize = file.tellg();
+	file.close();
+
+	// Count every "step"-th block of the file.
+	InBitStream in;
+	in.openFile(src);
+	unsigned step = opt.samplePercent >= 100 ? 1 : 100 / (opt.samplePercent == 0 ? 1 : opt.samplePercent);
+	FrequencyCounter sample;
+	char *block = new char[SAMPLE_BLOCK_SIZE];
+	unsigned long long pos = 0;
+	while (pos < estimate.originalSize) {
+		in.gotoPos(pos);
+		unsigned size = in.readBlock(block, SAMPLE_BLOCK_SIZE);
+		if (size == 0)
+			break;
+		sample.countBlock(block, size);
+		estimate.sampledSize += size;
+		pos += (unsigned long long)step * SAMPLE_BLOCK_SIZE;
+	}
+	delete [] block;
+	estimate.isExact = (estimate.sampledSize == estimate.originalSize);
+
+	// Scale the sampled weights up to the whole file.
+	unsigned weights[256];
+	const unsigned *sampleVector = sample.getBitVector();
+	for (int i = 0; i < 256; i++) {
+		unsigned long long weight = sampleVector[i];
+		if (estimate.isExact == false && estimate.sampledSize > 0)
+			weight = weight * estimate.originalSize / estimate.sampledSize;
+		weights[i] = (sampleVector[i] != 0 && weight == 0) ? 1 : (unsigned)weight;
+	}
+	FrequencyCounter counter;
+	counter.restoreTable(weights);
+
+	// The codes come from the static table if one is used,
+	// from the frequency table of the file otherwise.
+	if (opt.tableFile != NULL) {
+		FrequencyCounter table;
+		unsigned tableId;
+		if (loadStaticTable(opt.tableFile, table, tableId) == false)
+			return false;
+		HuffmanCode code(table);
+		estimate.headerSize = BIT_FLAG + TABLE_ID_SIZE + ORIGINAL_SIZE;
+		estimate.bodySize = code.getEncodedSize(weights);
+	} else {
+		HuffmanCode code(counter);
+		estimate.headerSize = frequencyTableSize(counter) + ORIGINAL_SIZE;
+		estimate.bodySize = code.getEncodedSize(weights);
+	}
+
+	estimate.compressedSize = estimate.headerSize + estimate.bodySize;
+	estimate.ratio = estimate.originalSize > 0 ? (double)estimate.compressedSize / estimate.originalSize : 0;
+	return true;
+} // estimateCompressedSize
+
+// Desc: Print the predicted compressed size of "src".
+// Post: Return 0 if success. Otherwise, return -1.
+int estimate(const char *src, const Options &opt) {
+	SizeEstimate estimate;
+	if (estimateCompressedSize(src, opt, estimate) == false)
+		return -1;
+
+	cout << src << " -> " << estimate.originalSize << " bytes" << endl;
+	cout << "Estimated compressed size: " << estimate.compressedSize << " bytes ("
+		<< estimate.headerSize << " header + " << estimate.bodySize << " body)"
+		<< (estimate.isExact ? ", exact" : "") << endl;
+	if (estimate.isExact == false)
+		cout << "Sampled " << estimate.sampledSize << " bytes (" << opt.samplePercent << "%)." << endl;
+	cout << "Estimated ratio: " << estimate.ratio * 100 << "%" << endl;
+	if (estimate.compressedSize > estimate.originalSize)
+		cout << "*** Size of compressed file > size of source file ***" << endl;
+	return 0;
+} // estimate
+
+// End of Estimate.cpp
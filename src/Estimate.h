@@ -0,0 +1,40 @@
+/*
+ * Estimate.h
+ *
+ * Description: Predict the size of the compressed file without
+ *              encoding or writing anything. The body size follows from
+ *              the frequency table and the code lengths, and the header
+ *              size from the frequency table alone, so one counting
+ *              pass (or a sample of the file) is enough.
+ *
+ *
+ */
+
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include "Options.h"
+
+class SizeEstimate {
+public:
+	unsigned long long originalSize;	// Size of the source file.
+	unsigned long long sampledSize;		// Bytes actually counted.
+	unsigned long long headerSize;		// Including the original size field.
+	unsigned long long bodySize;
+	unsigned long long compressedSize;	// headerSize + bodySize.
+	double ratio;						// compressedSize / originalSize.
+	bool isExact;						// The whole file was counted.
+
+	// Desc: Default constructor
+	SizeEstimate();
+}; // SizeEstimate
+
+// Desc: Predict the compressed size of "src" when compressed with "opt".
+//       Only "opt.samplePercent" percent of the file is counted (evenly
+//       spread blocks); the estimate is exact when it is 100.
+// Post: Return true if success. Otherwise, return false.
+bool estimateCompressedSize(const char *src, const Options &opt, SizeEstimate &estimate);
+
+#endif
+
+// End of Estimate.h
@@ -8,25 +8,22 @@
  *
  */
 
+#include <cstring>
 #include "OutBitStream.h"
 #include "FrequencyCounter.h"
 #include "HeaderFormat.h"
+#include "Filter.h"
 
 
-// Desc: Write the required information to the header of the compressed file.
-// Post: It returns the size of file-header (in bytes).
-int writeFileHeader(OutBitStream &out, FrequencyCounter &counter) {
-
-	// It's use for storing the size of file header.
-	int totalHeaderSize = 0;
+// Desc: Choose how the frequency table is stored: the value size and
+//       the storage mode (key-value pairs or a list of 256 values).
+// Post: It returns the bit flag, and the value size in "valueSize".
+static char chooseTableFormat(FrequencyCounter &counter, unsigned &valueSize) {
 
 	// Bit flag, in the first byte of the compressed file.
 	// To indicate some properties of the compressed file.
 	char bit_flag = 0;
 
-	// The size (number of bytes) of one single value from frequency table.
-	unsigned valueSize;
-
 	// It's the least significant bit of bit_flag, can be either 0 or 1.
 	// 		0: Frequency table will be written as some (key, value) pairs.
 	// 		1: Frequency table will be written as 256 consecutive values (weight).
@@ -35,9 +32,6 @@ int writeFileHeader(OutBitStream &out, FrequencyCounter &counter) {
 	// The maximum weight.
 	unsigned maxWeight = counter.getMaxWeight();
 
-	// Frequency information from the FrequencyCounter object.
-	unsigned *bitVector = counter.getBitVector();
-
 	// Dictionary size: the number of different characters in frequency table.
 	unsigned dictionarySize = counter.getSize();
 
@@ -90,8 +84,42 @@ int writeFileHeader(OutBitStream &out, FrequencyCounter &counter) {
 		}
 	}
 	
+	return bit_flag + compressionMode;
+} // chooseTableFormat
+
+// Desc: Return the number of bytes writeFrequencyTable() writes for "counter".
+int frequencyTableSize(FrequencyCounter &counter) {
+	unsigned valueSize;
+	char bit_flag = chooseTableFormat(counter, valueSize);
+	if ((bit_flag & 0x1) == 0)	// key-value pair mode
+		return BIT_FLAG + HEADER_BODY_SIZE_BYTE + (KEY_SIZE + valueSize) * counter.getSize();
+	else						// list mode
+		return BIT_FLAG + valueSize * 256;
+} // frequencyTableSize
+
+// Desc: Write the bit flag and the frequency table to the destination file.
+//       It is shared by the file header and the static table file.
+// Post: It returns the number of bytes written.
+int writeFrequencyTable(OutBitStream &out, FrequencyCounter &counter) {
+
+	// It's use for storing the size of file header.
+	int totalHeaderSize = 0;
+
+	// Bit flag, in the first byte of the compressed file.
+	// To indicate some properties of the compressed file.
+	unsigned valueSize;
+	char bit_flag = chooseTableFormat(counter, valueSize);
+
+	// Frequency information from the FrequencyCounter object.
+	unsigned *bitVector = counter.getBitVector();
+
+	// Dictionary size: the number of different characters in frequency table.
+	unsigned dictionarySize = counter.getSize();
+
+	// Storage mode, the least significant bit of bit_flag.
+	char compressionMode = bit_flag & 0x1;
+
 	// Write the bit flag to the beginning of the file.
-	bit_flag += compressionMode;
 	out.writeByte(bit_flag);
 	totalHeaderSize += BIT_FLAG;
 
@@ -127,25 +155,250 @@ int writeFileHeader(OutBitStream &out, FrequencyCounter &counter) {
 		totalHeaderSize += valueSize * 256;
 	}
 
+	// Return the size of the bit flag and the frequency table.
+	return totalHeaderSize;
+}
+
+// Desc: Write the required information to the header of the compressed file.
+// Post: It returns the size of file-header (in bytes).
+int writeFileHeader(OutBitStream &out, FrequencyCounter &counter) {
+
+	// Bit flag and frequency table.
+	int totalHeaderSize = writeFrequencyTable(out, counter);
+
 	// 4 bytes are preserved for indicating the file body size.
 	out.writeValue(0, ORIGINAL_SIZE);
 	totalHeaderSize += ORIGINAL_SIZE;
 
-
 	// Return the header size of the compressed file.
 	return totalHeaderSize;
 }
 
-// Desc: Read the information from the header of the compressed file.
+// Desc: Write the header of a file compressed with a pre-trained
+//       static table. Only the id of the table is stored.
+//       Format: [bit flag][table id][original size]
 // Post: It returns the size of file-header (in bytes).
-int readFileHeader(InBitStream &in, FrequencyCounter &counter) {
+int writeStaticFileHeader(OutBitStream &out, unsigned tableId) {
+	out.writeByte(STATIC_TABLE_FLAG);
+	out.writeValue(tableId, TABLE_ID_SIZE);
 
-	// It's use for storing the size of file header.
-	int totalHeaderSize = 0;
+	// 4 bytes are preserved for indicating the file body size.
+	out.writeValue(0, ORIGINAL_SIZE);
 
-	// Bit flag, in the first byte of the compressed file.
-	// To indicate some properties of the compressed file.
-	char bit_flag = 0;
+	return BIT_FLAG + TABLE_ID_SIZE + ORIGINAL_SIZE;
+}
+
+// Desc: Write the header of data coded by another method than plain
+//       Huffman coding (see "HeaderFormat.h").
+//       Format: [bit flag][method][original size][body size]
+//               ([filter type][stride] unless "filterType" is NO_FILTER)
+// Post: It returns the size of file-header (in bytes).
+int writeExtendedFileHeader(OutBitStream &out, char method, char filterType, unsigned stride) {
+	out.writeByte(filterType != NO_FILTER ? EXTENDED_FLAG | FILTER_FLAG : EXTENDED_FLAG);
+	out.writeByte(method);
+
+	// The sizes are written once the body is complete.
+	out.writeValue(0, ORIGINAL_SIZE);
+	out.writeBlock("\0\0\0\0\0\0\0\0", BODY_SIZE_SIZE);
+
+	if (filterType == NO_FILTER)
+		return EXTENDED_HEADER_SIZE;
+	out.writeByte(filterType);
+	out.writeValue(stride, FILTER_STRIDE_SIZE);
+	return FILTERED_HEADER_SIZE;
+}
+
+// Desc: Return the number of bytes of "value" as a variable-length
+//       integer.
+static unsigned varintSize(unsigned value) {
+	unsigned size = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
+// Desc: Write "value" as a variable-length integer: 7 bits per byte,
+//       least significant first, with the high bit set on all bytes
+//       but the last.
+static void writeVarint(OutBitStream &out, unsigned value) {
+	while (value >= 0x80) {
+		out.writeByte((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.writeByte((char)value);
+}
+
+// Desc: Read a variable-length integer at "data", before "end".
+// Post: It returns false if the data ends, or the value is too long.
+static bool readVarint(const char *&data, const char *end, unsigned &value) {
+	value = 0;
+	for (unsigned shift = 0; shift < 32; shift += 7) {
+		if (data == end)
+			return false;
+		unsigned char c = *data++;
+		value |= (unsigned)(c & 0x7F) << shift;
+		if ((c & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Desc: Choose how the weights of "numOfSymbols" symbols are stored:
+//       the value size, and whether (key, value) pairs or (gap, value)
+//       variable-length pairs take less space than the list of all values.
+// Post: It returns the format byte, and the value size in "valueSize"
+//       and the number of symbols that occur in "count". For the
+//       variable-length pairs, "valueSize" is their size in bytes.
+static char chooseWeightFormat(const unsigned *weights, unsigned numOfSymbols, unsigned &valueSize, unsigned &count) {
+	unsigned maxWeight = 0;
+	unsigned varintBytes = 0;
+	count = 0;
+	for (unsigned i = 0, key = 0; i < numOfSymbols; i++) {
+		if (weights[i] > maxWeight)
+			maxWeight = weights[i];
+		if (weights[i] != 0) {
+			varintBytes += varintSize(i - key) + varintSize(weights[i]);
+			key = i + 1;
+			count++;
+		}
+	}
+	if (maxWeight <= 255)
+		valueSize = CHAR_VALUE_SIZE;
+	else if (maxWeight <= 65535)
+		valueSize = SHORT_VALUE_SIZE;
+	else
+		valueSize = UNSIGNED_VALUE_SIZE;
+
+	unsigned pairsSize = WEIGHT_COUNT_SIZE + (SYMBOL_KEY_SIZE + valueSize) * count;
+	if (WEIGHT_COUNT_SIZE + varintBytes < pairsSize && WEIGHT_COUNT_SIZE + varintBytes < valueSize * numOfSymbols) {
+		valueSize = varintBytes;
+		return WEIGHT_VARINT_FLAG;
+	}
+	if (pairsSize < valueSize * numOfSymbols)
+		return valueSize | WEIGHT_PAIRS_FLAG;
+	return valueSize;
+}
+
+// Desc: Return the number of bytes writeWeights() writes for "weights".
+int weightsSize(const unsigned *weights, unsigned numOfSymbols) {
+	unsigned valueSize, count;
+	char format = chooseWeightFormat(weights, numOfSymbols, valueSize, count);
+	if (format == WEIGHT_VARINT_FLAG)
+		return WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE + valueSize;
+	if ((format & WEIGHT_PAIRS_FLAG) != 0)
+		return WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE + (SYMBOL_KEY_SIZE + valueSize) * count;
+	return WEIGHT_FORMAT_SIZE + valueSize * numOfSymbols;
+}
+
+// Desc: Write the weights of an alphabet of "numOfSymbols" symbols,
+//       e.g. the literals and lengths of the LZ77 method.
+//  Pre: numOfSymbols <= 65536.
+// Post: It returns the number of bytes written.
+int writeWeights(OutBitStream &out, const unsigned *weights, unsigned numOfSymbols) {
+	unsigned valueSize, count;
+	char format = chooseWeightFormat(weights, numOfSymbols, valueSize, count);
+	out.writeByte(format);
+	if (format == WEIGHT_VARINT_FLAG) {
+		out.writeValue(count, WEIGHT_COUNT_SIZE);
+		for (unsigned i = 0, key = 0; i < numOfSymbols; i++) {
+			if (weights[i] != 0) {
+				writeVarint(out, i - key);
+				writeVarint(out, weights[i]);
+				key = i + 1;
+			}
+		}
+		return WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE + valueSize;
+	}
+	if ((format & WEIGHT_PAIRS_FLAG) != 0) {
+		out.writeValue(count, WEIGHT_COUNT_SIZE);
+		for (unsigned i = 0; i < numOfSymbols; i++) {
+			if (weights[i] != 0) {
+				out.writeValue(i, SYMBOL_KEY_SIZE);
+				out.writeValue(weights[i], valueSize);
+			}
+		}
+		return WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE + (SYMBOL_KEY_SIZE + valueSize) * count;
+	}
+	for (unsigned i = 0; i < numOfSymbols; i++)
+		out.writeValue(weights[i], valueSize);
+	return WEIGHT_FORMAT_SIZE + valueSize * numOfSymbols;
+}
+
+// Desc: Convert "valueSize" bytes of data to an unsigned value.
+static unsigned readValue(const char *data, unsigned valueSize) {
+	unsigned value = 0;
+	memcpy(&value, data, valueSize);
+	return value;
+}
+
+// Desc: Parse the weights written by writeWeights().
+// Post: It returns the number of bytes parsed, or 0 if "size"
+//       bytes are not enough or the weights are not valid.
+int parseWeights(const char *data, unsigned size, unsigned *weights, unsigned numOfSymbols) {
+	if (size < WEIGHT_FORMAT_SIZE)
+		return 0;
+	char format = data[0];
+	if (format == WEIGHT_VARINT_FLAG) {
+
+		// Variable-length (gap, value) pairs.
+		if (size < WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE)
+			return 0;
+		unsigned count = readValue(data + WEIGHT_FORMAT_SIZE, WEIGHT_COUNT_SIZE);
+		if (count > numOfSymbols)
+			return 0;
+		for (unsigned i = 0; i < numOfSymbols; i++)
+			weights[i] = 0;
+		const char *ptr = data + WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE;
+		unsigned key = 0;
+		for (unsigned i = 0; i < count; i++) {
+			unsigned gap, value;
+			if (readVarint(ptr, data + size, gap) == false || readVarint(ptr, data + size, value) == false ||
+				gap >= numOfSymbols - key || value == 0)
+				return 0;
+			key += gap;
+			weights[key++] = value;
+		}
+		return ptr - data;
+	}
+	unsigned valueSize = format & ~WEIGHT_PAIRS_FLAG;
+	if (valueSize != CHAR_VALUE_SIZE && valueSize != SHORT_VALUE_SIZE && valueSize != UNSIGNED_VALUE_SIZE)
+		return 0;
+
+	if ((format & WEIGHT_PAIRS_FLAG) == 0) {
+		if (size < WEIGHT_FORMAT_SIZE + valueSize * numOfSymbols)
+			return 0;
+		for (unsigned i = 0; i < numOfSymbols; i++)
+			weights[i] = readValue(data + WEIGHT_FORMAT_SIZE + i * valueSize, valueSize);
+		return WEIGHT_FORMAT_SIZE + valueSize * numOfSymbols;
+	}
+
+	// Key-value pair mode.
+	if (size < WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE)
+		return 0;
+	unsigned count = readValue(data + WEIGHT_FORMAT_SIZE, WEIGHT_COUNT_SIZE);
+	if (count > numOfSymbols || size < WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE + (SYMBOL_KEY_SIZE + valueSize) * count)
+		return 0;
+	for (unsigned i = 0; i < numOfSymbols; i++)
+		weights[i] = 0;
+	const char *ptr = data + WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE;
+	for (unsigned i = 0; i < count; i++, ptr += SYMBOL_KEY_SIZE + valueSize) {
+		unsigned key = readValue(ptr, SYMBOL_KEY_SIZE);
+		if (key >= numOfSymbols)
+			return 0;
+		weights[key] = readValue(ptr + SYMBOL_KEY_SIZE, valueSize);
+	}
+	return WEIGHT_FORMAT_SIZE + WEIGHT_COUNT_SIZE + (SYMBOL_KEY_SIZE + valueSize) * count;
+}
+
+// Desc: Parse the frequency table that follows the given bit flag.
+// Post: It returns the number of bytes parsed (excluding the bit flag),
+//       or 0 if "size" bytes are not enough.
+static int parseTableBody(const char *data, unsigned size, FrequencyCounter &counter, char bit_flag) {
+
+	// It's use for storing the size of the frequency table.
+	unsigned totalHeaderSize = 0;
 
 	// The size (number of bytes) of one single value from frequency table.
 	unsigned valueSize;
@@ -155,22 +408,13 @@ int readFileHeader(InBitStream &in, FrequencyCounter &counter) {
 	// 		1: Frequency table will be written as 256 consecutive values.
 	char compressionMode;
 
-	// // The maximum weight.
-	// unsigned maxWeight = counter.getMaxWeight();
-
 	// Frequency information.
-	unsigned *bitVector = new unsigned[256];
-	for (int i = 0; i < 256; i++)	// Clear the random data.
-		bitVector[i] = 0;
+	unsigned bitVector[256] = {0};
 
 	// Dictionary size: the number of different character in frequency table.
 	unsigned dictionarySize = 0;
 
 
-	in.loadNextByte();
-	bit_flag = in.getCharacter();
-	totalHeaderSize++;
-
 	compressionMode = bit_flag & 0x1;	// Get the least significant bit of bit flag.
 
 	valueSize = (((unsigned)bit_flag) & 0x6);	// Get last second and last third bits.
@@ -184,35 +428,110 @@ int readFileHeader(InBitStream &in, FrequencyCounter &counter) {
 	}
 
 	if (compressionMode == 0x0) {	// key-value pair mode.
-		char key;
-		unsigned value;
 
 		// Read the dictionary size (The number of key-value pairs).
-		dictionarySize = in.readValue(HEADER_BODY_SIZE_BYTE);
-		totalHeaderSize++;
-
+		if (size < HEADER_BODY_SIZE_BYTE)
+			return 0;
+		dictionarySize = readValue(data, HEADER_BODY_SIZE_BYTE);
+		totalHeaderSize = HEADER_BODY_SIZE_BYTE + dictionarySize * (KEY_SIZE + valueSize);
+		if (size < totalHeaderSize)
+			return 0;
+
+		const char *ptr = data + HEADER_BODY_SIZE_BYTE;
 		for (unsigned i = 0; i < dictionarySize; i++) {
-			in.loadNextByte();
-			key = in.getCharacter();
-			value = in.readValue(valueSize);
-			bitVector[key + 128] = value;
+			char key = ptr[0];
+			bitVector[key + 128] = readValue(ptr + KEY_SIZE, valueSize);
+			ptr += KEY_SIZE + valueSize;
 		}
-		totalHeaderSize += dictionarySize * (KEY_SIZE + valueSize);
 	} else {
-		unsigned value;
+		totalHeaderSize = 256 * valueSize;
+		if (size < totalHeaderSize)
+			return 0;
 		for (unsigned i = 0; i < 256; i++) {
-			value = in.readValue(valueSize);
-			bitVector[i] = value;
+			bitVector[i] = readValue(data + i * valueSize, valueSize);
 		}
-		totalHeaderSize += 256 * valueSize;
 	}
 
 	// Restore the frequency table using a bit vector.
 	counter.restoreTable(bitVector);
 
-	delete [] bitVector;
-
 	return totalHeaderSize;
 }
 
+// Desc: Parse the bit flag and the frequency table.
+//       It is shared by the file header and the static table file.
+// Post: It returns the number of bytes parsed,
+//       or 0 if "size" bytes are not enough.
+int parseFrequencyTable(const char *data, unsigned size, FrequencyCounter &counter) {
+	if (size < BIT_FLAG)
+		return 0;
+	int tableSize = parseTableBody(data + BIT_FLAG, size - BIT_FLAG, counter, data[0]);
+	return tableSize == 0 ? 0 : BIT_FLAG + tableSize;
+}
+
+// Desc: Parse the header at the beginning of the compressed data.
+//       In static table mode, the frequency table is not stored. Then
+//       "tableId" is set to the id of the required table and "counter" 
+//       is left unchanged. Otherwise, "tableId" is set to 0.
+// Post: It returns the size of file-header (in bytes), including the 
+//       original file size. It returns 0 if "size" bytes are not enough.
+//       A complete header is never longer than MAX_HEADER_SIZE bytes.
+int parseFileHeader(const char *data, unsigned size, FrequencyCounter &counter, unsigned &tableId, unsigned &originalFileSize) {
+	unsigned totalHeaderSize;
+
+	// Bit flag, in the first byte of the compressed file.
+	// To indicate some properties of the compressed file.
+	if (size < BIT_FLAG)
+		return 0;
+	char bit_flag = data[0];
+
+	// Extended headers are read by parseExtendedFileHeader().
+	if ((bit_flag & EXTENDED_FLAG) != 0)
+		return 0;
+
+	if ((bit_flag & STATIC_TABLE_FLAG) != 0) {	// Static table mode.
+		totalHeaderSize = BIT_FLAG + TABLE_ID_SIZE;
+		if (size < totalHeaderSize)
+			return 0;
+		tableId = readValue(data + BIT_FLAG, TABLE_ID_SIZE);
+	} else {
+		int tableSize = parseTableBody(data + BIT_FLAG, size - BIT_FLAG, counter, bit_flag);
+		if (tableSize == 0)
+			return 0;
+		totalHeaderSize = BIT_FLAG + tableSize;
+		tableId = 0;
+	}
+
+	// The original file size is at the end of the header.
+	if (size < totalHeaderSize + ORIGINAL_SIZE)
+		return 0;
+	originalFileSize = readValue(data + totalHeaderSize, ORIGINAL_SIZE);
+
+	return totalHeaderSize + ORIGINAL_SIZE;
+}
+
+// Desc: Parse an extended header (see "HeaderFormat.h").
+//       The filter is NO_FILTER (with a stride of 1) if there is none.
+// Post: It returns the size of file-header (in bytes), or 0 if it is
+//       not an extended header or "size" bytes are not enough.
+int parseExtendedFileHeader(const char *data, unsigned size, char &method, unsigned &originalFileSize, 
+	unsigned long long &bodySize, char &filterType, unsigned &stride) {
+	if (size < EXTENDED_HEADER_SIZE || (data[0] & ~FILTER_FLAG) != EXTENDED_FLAG)
+		return 0;
+	method = data[BIT_FLAG];
+	originalFileSize = readValue(data + BIT_FLAG + METHOD_SIZE, ORIGINAL_SIZE);
+	bodySize = 0;
+	memcpy(&bodySize, data + BIT_FLAG + METHOD_SIZE + ORIGINAL_SIZE, BODY_SIZE_SIZE);
+
+	filterType = NO_FILTER;
+	stride = 1;
+	if ((data[0] & FILTER_FLAG) == 0)
+		return EXTENDED_HEADER_SIZE;
+	if (size < FILTERED_HEADER_SIZE)
+		return 0;
+	filterType = data[EXTENDED_HEADER_SIZE];
+	stride = readValue(data + EXTENDED_HEADER_SIZE + FILTER_TYPE_SIZE, FILTER_STRIDE_SIZE);
+	return FILTERED_HEADER_SIZE;
+}
+
 // End of FileHeaderHandler.cpp
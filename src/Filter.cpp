@@ -0,0 +1,257 @@
+/*
+ * Filter.cpp
+ *
+ * Description: Reversible filters for arrays of fixed-size values.
+ *              The loops run over whole blocks, without a branch per
+ *              byte, so that the compiler can vectorize them.
+ *
+ *
+ */
+
+#include <cstring>
+#include <cmath>
+#include "Filter.h"
+
+using namespace std;
+
+// Number of values filtered at once.
+static const unsigned FILTER_BLOCK_VALUES = 1 << 16;
+
+// A larger stride (or another type) must lower the entropy by this
+// fraction to be chosen, since a multiple of the right stride fits as
+// well, and a small sample favors many planes slightly.
+static const double STRIDE_GAIN = 0.01;
+
+// A filter must lower the entropy by this fraction to be used at all.
+static const double FILTER_GAIN = 0.03;
+
+// Smallest number of bytes per plane for which a stride is tried.
+// Smaller histograms always look skewed.
+static const unsigned MIN_PLANE_SIZE = 4096;
+
+// Desc: Constructor
+Filter::Filter(char type, unsigned stride) {
+	this -> type = type;
+	this -> stride = stride;
+	blockSize = stride * FILTER_BLOCK_VALUES;
+	block.resize(blockSize);
+	filtered.resize(blockSize);
+	work.resize(blockSize);
+	position = 0;
+	length = 0;
+	memset(history, 0, sizeof(history));
+} // Constructor
+
+// Desc: Keep the last "stride" of the "size" original bytes "data".
+void Filter::updateHistory(const char *data, unsigned size) {
+	if (size >= stride) {
+		memcpy(history, data + size - stride, stride);
+	} else {
+		memmove(history, history + size, stride - size);
+		memcpy(history + stride - size, data, size);
+	}
+} // updateHistory
+
+// Desc: Filter the "size" bytes of "src" into "dst", following the
+//       previous block.
+void Filter::forward(const char *src, char *dst, unsigned size) {
+	const char *values = src;
+	if (type != SPLIT_FILTER) {
+		char *diff = work.data();
+		unsigned head = size < stride ? size : stride;
+		if (type == DELTA_FILTER) {
+			for (unsigned i = 0; i < head; i++)
+				diff[i] = src[i] - history[i];
+			for (unsigned i = head; i < size; i++)
+				diff[i] = src[i] - src[i - stride];
+		} else {
+			for (unsigned i = 0; i < head; i++)
+				diff[i] = src[i] ^ history[i];
+			for (unsigned i = head; i < size; i++)
+				diff[i] = src[i] ^ src[i - stride];
+		}
+		values = diff;
+	}
+	updateHistory(src, size);
+
+	// Split into planes. A partial value at the end stays as it is.
+	unsigned count = size / stride;
+	for (unsigned k = 0; k < stride; k++) {
+		char *plane = dst + k * count;
+		for (unsigned j = 0; j < count; j++)
+			plane[j] = values[j * stride + k];
+	}
+	memcpy(dst + count * stride, values + count * stride, size - count * stride);
+} // forward
+
+// Desc: Undo forward() for the "size" bytes of "src" into "dst".
+void Filter::backward(const char *src, char *dst, unsigned size) {
+	char *values = type == SPLIT_FILTER ? dst : work.data();
+
+	// Join the planes.
+	unsigned count = size / stride;
+	for (unsigned k = 0; k < stride; k++) {
+		const char *plane = src + k * count;
+		for (unsigned j = 0; j < count; j++)
+			values[j * stride + k] = plane[j];
+	}
+	memcpy(values + count * stride, src + count * stride, size - count * stride);
+
+	if (type != SPLIT_FILTER) {
+		unsigned head = size < stride ? size : stride;
+		if (type == DELTA_FILTER) {
+			for (unsigned i = 0; i < head; i++)
+				dst[i] = values[i] + history[i];
+			for (unsigned i = head; i < size; i++)
+				dst[i] = values[i] + dst[i - stride];
+		} else {
+			for (unsigned i = 0; i < head; i++)
+				dst[i] = values[i] ^ history[i];
+			for (unsigned i = head; i < size; i++)
+				dst[i] = values[i] ^ dst[i - stride];
+		}
+	}
+	updateHistory(dst, size);
+} // backward
+
+// Desc: Read up to "size" bytes from "in" and filter them into "data".
+// Post: Returns the number of bytes, 0 at the end of file.
+unsigned Filter::read(InBitStream &in, char *data, unsigned size) {
+	unsigned total = 0;
+	while (total < size) {
+		if (position == length) {
+			length = in.readBlock(block.data(), blockSize);
+			position = 0;
+			if (length == 0)
+				break;
+			forward(block.data(), filtered.data(), length);
+		}
+		unsigned numOfBytes = length - position;
+		if (numOfBytes > size - total)
+			numOfBytes = size - total;
+		memcpy(data + total, filtered.data() + position, numOfBytes);
+		position += numOfBytes;
+		total += numOfBytes;
+	}
+	return total;
+} // read
+
+// Desc: Undo the filter for the next "size" bytes of "data", and
+//       write them to "out". The last block is written by flush().
+void Filter::write(OutBitStream &out, const char *data, unsigned size) {
+	while (size > 0) {
+		unsigned numOfBytes = blockSize - length;
+		if (numOfBytes > size)
+			numOfBytes = size;
+		memcpy(filtered.data() + length, data, numOfBytes);
+		length += numOfBytes;
+		data += numOfBytes;
+		size -= numOfBytes;
+		if (length == blockSize)
+			flush(out);
+	}
+} // write
+
+// Desc: Write the bytes kept by write().
+void Filter::flush(OutBitStream &out) {
+	if (length == 0)
+		return;
+	backward(filtered.data(), block.data(), length);
+	out.writeBlock(block.data(), length);
+	length = 0;
+} // flush
+
+// Desc: Undo the filter for the "size" bytes of "data", in place.
+void Filter::revert(char *data, unsigned long long size) {
+	for (unsigned long long offset = 0; offset < size; offset += blockSize) {
+		unsigned numOfBytes = size - offset < blockSize ? size - offset : blockSize;
+		memcpy(filtered.data(), data + offset, numOfBytes);
+		backward(filtered.data(), data + offset, numOfBytes);
+	}
+} // revert
+
+// Desc: Return the number of bytes filtered at once.
+unsigned Filter::getBlockSize() const {
+	return blockSize;
+} // getBlockSize
+
+
+// Desc: Return the order-0 entropy (in bits) of the "size" bytes of
+//       "data", with a separate histogram for each of the "stride"
+//       planes.
+static double planeEntropy(const unsigned char *data, unsigned size, unsigned stride) {
+	vector<unsigned> histogram(stride * 256, 0);
+	for (unsigned i = 0; i + stride <= size; i += stride) {
+		for (unsigned k = 0; k < stride; k++)
+			histogram[k * 256 + data[i + k]]++;
+	}
+	double bits = 0;
+	unsigned count = size / stride;
+	for (unsigned i = 0; i < histogram.size(); i++) {
+		if (histogram[i] != 0)
+			bits -= histogram[i] * log2((double)histogram[i] / count);
+	}
+	return bits;
+} // planeEntropy
+
+// Desc: Choose the filter that leaves "sample" with the smallest
+//       order-0 entropy, plane by plane.
+void detectFilter(const char *sample, unsigned size, char &type, unsigned &stride) {
+	char firstType = type == AUTO_FILTER ? SPLIT_FILTER : type;
+	char lastType = type == AUTO_FILTER ? XOR_FILTER : type;
+	unsigned firstStride = stride == 0 ? 1 : stride;
+	unsigned lastStride = stride == 0 ? MAX_FILTER_STRIDE : stride;
+
+	const unsigned char *src = (const unsigned char *)sample;
+	vector<unsigned char> diff(size);
+	double original = planeEntropy(src, size, 1);
+	double best = type == AUTO_FILTER ? original : HUGE_VAL;
+	char bestType = type == AUTO_FILTER ? NO_FILTER : type;
+	unsigned bestStride = firstStride;
+	for (unsigned s = firstStride; s <= lastStride && (s == firstStride || s * MIN_PLANE_SIZE <= size); s++) {
+		for (char t = firstType; t <= lastType; t++) {
+			const unsigned char *values = src;
+			if (t == DELTA_FILTER) {
+				for (unsigned i = s; i < size; i++)
+					diff[i] = src[i] - src[i - s];
+				values = diff.data();
+			} else if (t == XOR_FILTER) {
+				for (unsigned i = s; i < size; i++)
+					diff[i] = src[i] ^ src[i - s];
+				values = diff.data();
+			}
+			double bits = size > s ? planeEntropy(values + s, size - s, s) : 0;
+			if (bits < best * (1 - STRIDE_GAIN)) {
+				best = bits;
+				bestType = t;
+				bestStride = s;
+			}
+		}
+	}
+
+	if (type == AUTO_FILTER && best > original * (1 - FILTER_GAIN)) {
+		bestType = NO_FILTER;
+		bestStride = 1;
+	}
+	type = bestType;
+	stride = bestStride;
+} // detectFilter
+
+// Desc: Choose the frame size, up to "maxFrameSize" bytes, that leaves
+//       "sample" with the smallest order-0 entropy, position by position.
+unsigned detectFrameSize(const char *sample, unsigned size, unsigned maxFrameSize) {
+	const unsigned char *src = (const unsigned char *)sample;
+	double original = planeEntropy(src, size, 1);
+	double best = original;
+	unsigned bestFrameSize = 1;
+	for (unsigned s = 2; s <= maxFrameSize && s * MIN_PLANE_SIZE <= size; s++) {
+		double bits = planeEntropy(src, size, s);
+		if (bits < best * (1 - STRIDE_GAIN)) {
+			best = bits;
+			bestFrameSize = s;
+		}
+	}
+	return best > original * (1 - FILTER_GAIN) ? 1 : bestFrameSize;
+} // detectFrameSize
+
+// End of Filter.cpp
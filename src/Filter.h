@@ -0,0 +1,103 @@
+/*
+ * Filter.h
+ *
+ * Description: Reversible filters for arrays of fixed-size values
+ *              (integers, floats, records of "stride" bytes). The delta
+ *              and XOR filters replace each byte by its difference with
+ *              the byte "stride" positions earlier, which is the same
+ *              byte of the previous value. All filters then split the
+ *              bytes into planes: byte 0 of every value, then byte 1,
+ *              and so on. The data is filtered in blocks of 65536
+ *              values, and read and written as a stream.
+ *
+ *
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <vector>
+#include "InBitStream.h"
+#include "OutBitStream.h"
+
+using namespace std;
+
+// Filter types, as stored in the header.
+const char NO_FILTER = 0;
+const char SPLIT_FILTER = 1;
+const char DELTA_FILTER = 2;
+const char XOR_FILTER = 3;
+
+// Only for detectFilter(): choose the type from the data.
+const char AUTO_FILTER = 4;
+
+// Largest stride, in bytes.
+const unsigned MAX_FILTER_STRIDE = 16;
+
+class Filter {
+private:
+	char type;			// SPLIT_FILTER, DELTA_FILTER or XOR_FILTER
+	unsigned stride;	// Size of one value, in bytes.
+	unsigned blockSize;	// Number of bytes filtered at once.
+	vector<char> block;		// Original bytes of the current block.
+	vector<char> filtered;	// Filtered bytes of the current block.
+	vector<char> work;		// Differences, before they are split.
+	unsigned position;	// Number of bytes of "filtered" read.
+	unsigned length;	// Number of bytes in "filtered".
+	char history[MAX_FILTER_STRIDE];	// The last "stride" original bytes.
+
+	// Desc: Keep the last "stride" of the "size" original bytes "data".
+	void updateHistory(const char *data, unsigned size);
+
+public:
+	// Desc: Constructor
+	//  Pre: "type" is SPLIT_FILTER, DELTA_FILTER or XOR_FILTER, and
+	//       "stride" is between 1 and MAX_FILTER_STRIDE.
+	Filter(char type, unsigned stride);
+
+	// Desc: Filter the "size" bytes of "src" into "dst", following the
+	//       previous block.
+	//  Pre: "size" is at most getBlockSize(), and only the last block
+	//       is shorter. "src" and "dst" do not overlap.
+	void forward(const char *src, char *dst, unsigned size);
+
+	// Desc: Undo forward() for the "size" bytes of "src" into "dst".
+	//  Pre: Same as forward().
+	void backward(const char *src, char *dst, unsigned size);
+
+	// Desc: Read up to "size" bytes from "in" and filter them into "data".
+	// Post: Returns the number of bytes, 0 at the end of file.
+	unsigned read(InBitStream &in, char *data, unsigned size);
+
+	// Desc: Undo the filter for the next "size" bytes of "data", and
+	//       write them to "out". The last block is written by flush().
+	void write(OutBitStream &out, const char *data, unsigned size);
+
+	// Desc: Write the bytes kept by write().
+	void flush(OutBitStream &out);
+
+	// Desc: Undo the filter for the "size" bytes of "data", in place.
+	void revert(char *data, unsigned long long size);
+
+	// Desc: Return the number of bytes filtered at once.
+	unsigned getBlockSize() const;
+
+}; // Filter
+
+// Desc: Choose the filter that leaves the "size" bytes of "sample" with
+//       the smallest order-0 entropy, plane by plane. If "type" is
+//       AUTO_FILTER, every type is tried (and NO_FILTER is chosen if none
+//       helps). If "stride" is 0, every stride is tried.
+// Post: "type" and "stride" are set to the filter chosen.
+void detectFilter(const char *sample, unsigned size, char &type, unsigned &stride);
+
+// Desc: Choose the frame size, up to "maxFrameSize" bytes, that leaves
+//       the "size" bytes of "sample" with the smallest order-0 entropy
+//       when each byte position within a frame has its own histogram
+//       (see "HuffmanBlocks.h").
+// Post: Returns the frame size, 1 if no frame size helps.
+unsigned detectFrameSize(const char *sample, unsigned size, unsigned maxFrameSize);
+
+#endif
+
+// End of Filter.h
@@ -11,22 +11,36 @@
 #include "InBitStream.h"
 #include "HuffmanTreeNode.h"
 #include "PriorityQueue.h"
+#include "Trace.h"
 
 
 // Desc: Default constructor
 FrequencyCounter::FrequencyCounter() {
 	size = 0;
+	numOfSymbols = 256;
 	bitVector = new unsigned[256];
 	for (int i = 0; i < 256; i++) {
 		bitVector[i] = 0;
 	}
 } // Default constructor
 
+// Desc: Non-default constructor
+//       A table of "numOfSymbols" symbols, e.g. 65536 for 16-bit symbols.
+FrequencyCounter::FrequencyCounter(unsigned numOfSymbols) {
+	size = 0;
+	this -> numOfSymbols = numOfSymbols;
+	bitVector = new unsigned[numOfSymbols];
+	for (unsigned i = 0; i < numOfSymbols; i++) {
+		bitVector[i] = 0;
+	}
+} // Non-default constructor
+
 // Desc: Non-default constructor
 FrequencyCounter::FrequencyCounter(const FrequencyCounter &counter) {
 	size = counter.size;
-	bitVector = new unsigned[256];
-	for (int i = 0; i < 256; i++) {
+	numOfSymbols = counter.numOfSymbols;
+	bitVector = new unsigned[numOfSymbols];
+	for (unsigned i = 0; i < numOfSymbols; i++) {
 		bitVector[i] = counter.bitVector[i];
 	}
 } // Non-default constructor
@@ -41,6 +55,11 @@ unsigned FrequencyCounter::getSize() const {
 	return size;
 } // getSize
 
+// Desc: Return the number of entries of the bit vector.
+unsigned FrequencyCounter::getNumOfSymbols() const {
+	return numOfSymbols;
+} // getNumOfSymbols
+
 // Desc: Return the character with maximum weight.
 char FrequencyCounter::getMaxChar() const {
 	int maxIdx = 0;
@@ -63,6 +82,7 @@ unsigned *FrequencyCounter::getBitVector() {
 
 // Desc: Read data from the file and create the frequency table.
 void FrequencyCounter::createTable(InBitStream &in) {
+	TRACE_SCOPE("count");
 
 	// Count the frequencies.
 	while (in.loadNextByte() == true) {
@@ -73,11 +93,32 @@ void FrequencyCounter::createTable(InBitStream &in) {
 
 } // createTable
 
+// Desc: Add the characters of a data block to the frequency table.
+void FrequencyCounter::countBlock(const char *data, unsigned length) {
+	for (unsigned i = 0; i < length; i++) {
+		if (bitVector[data[i] + 128] == 0)
+			size++;
+		bitVector[data[i] + 128]++;
+	}
+} // countBlock
+
+// Desc: Add the "length" 16-bit little-endian symbols of "data" to the
+//       frequency table.
+void FrequencyCounter::countWideBlock(const char *data, unsigned length) {
+	const unsigned char *bytes = (const unsigned char *)data;
+	for (unsigned i = 0; i < length; i++) {
+		unsigned symbol = bytes[2 * i] | bytes[2 * i + 1] << 8;
+		if (bitVector[symbol] == 0)
+			size++;
+		bitVector[symbol]++;
+	}
+} // countWideBlock
+
 // Desc: Restore the table using a bit vector.
 void FrequencyCounter::restoreTable(const unsigned *table) {
 
 	// Restore the frequency table.
-	for (int i = 0; i < 256; i++) {
+	for (unsigned i = 0; i < numOfSymbols; i++) {
 		bitVector[i] = table[i];
 		if (table[i] != 0)
 			size++;
@@ -86,7 +127,18 @@ void FrequencyCounter::restoreTable(const unsigned *table) {
 } // restoreTable
 
 // Desc: Push the frequency information into a priority queue.
+//  Pre: "pq" has room for getSize() nodes.
 void FrequencyCounter::createPriorityQueue(PriorityQueue &pq) {
+	if (numOfSymbols != 256) {
+		for (unsigned i = 0; i < numOfSymbols; i++) {
+			if (bitVector[i] != 0) {
+				// (weight, symbol)
+				HuffmanTreeNode *nodePtr = new HuffmanTreeNode(bitVector[i], i);
+				pq.enqueue(nodePtr);
+			}
+		}
+		return;
+	}
 	for (int i = 0; i < 256; i++) {
 		if (bitVector[i] != 0) {
 			// (type, weight, character)
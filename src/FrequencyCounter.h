@@ -13,6 +13,9 @@
 #include "InBitStream.h"
 #include "PriorityQueue.h"
 
+// The table is indexed by symbol (see HuffmanTreeNode::symbol): the
+// 256 characters at "character + 128", or the values of a wider alphabet
+// (e.g. 16-bit symbols) as they are.
 class FrequencyCounter {
 private:
 	unsigned *bitVector;	// Bit vector
@@ -20,16 +23,23 @@ private:
 	// The number of different characters in the frequency table.
 	unsigned size;
 
+	// The number of entries of the bit vector.
+	unsigned numOfSymbols;
+
 public:
 
 	// Constructors and destructor
 	FrequencyCounter();
+	FrequencyCounter(unsigned numOfSymbols);
 	FrequencyCounter(const FrequencyCounter &counter);
 	~FrequencyCounter();
 
 	// Desc: Return the number of different characters in the frequency table.
 	unsigned getSize() const;
 
+	// Desc: Return the number of entries of the bit vector.
+	unsigned getNumOfSymbols() const;
+
 	// Desc: Return the character with maximum weight.
 	char getMaxChar() const;
 
@@ -42,6 +52,14 @@ public:
 	// Desc: Read data from the file and create the frequency table.
 	void createTable(InBitStream &in);
 
+	// Desc: Add the characters of a data block to the frequency table.
+	void countBlock(const char *data, unsigned length);
+
+	// Desc: Add the "length" 16-bit little-endian symbols of "data" to the
+	//       frequency table.
+	//  Pre: The table has 65536 entries.
+	void countWideBlock(const char *data, unsigned length);
+
 	// Desc: Restore the table using a bit vector.
 	void restoreTable(const unsigned *table);
 
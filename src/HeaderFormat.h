@@ -21,9 +21,80 @@
 // 			00: char 		1 byte
 // 			01: short 		2 bytes
 // 			10: unsigned 	4 bytes
-// Bit 7 - 3: Unused.
+// Bit 3: Static table mode.
+// 			0: The frequency table is stored in the header.
+// 			1: The frequency table is not stored. A pre-trained
+//             table is referenced by its id instead.
+//             Format: [bit flag][table id][original size]
+// Bit 5 & 4: Unused.
+// Bit 6: Filter (extended mode only).
+// 			0: The data is coded as it is.
+// 			1: The data is filtered before it is coded (see "Filter.h").
+//             Format: [extended header][filter type][stride]
+// Bit 7: Extended mode.
+// 			0: The characters are Huffman coded as they are.
+// 			1: The data is coded by the method named in the next byte,
+//             and the other bits of the bit flag are 0, except bit 6.
+//             The body size is stored, since it does not follow from
+//             a frequency table.
+//             Format: [bit flag][method][original size][body size]
 const unsigned BIT_FLAG = 1;
 
+// Mask of the static table bit in the bit flag.
+const char STATIC_TABLE_FLAG = 0x8;
+
+// Bit flag of an extended header.
+const char EXTENDED_FLAG = (char)0x80;
+
+// Mask of the filter bit of an extended header.
+const char FILTER_FLAG = 0x40;
+
+// Coding methods of an extended header. The body starts with
+// the parameters of the method.
+// LZ77: Repeated strings are replaced by (length, distance) pairs,
+//       which are Huffman coded along with the literals (see "Lz77.h").
+// BWT:  Blocks are sorted with the Burrows-Wheeler transform, then
+//       move-to-front and zero-run coded (see "Bwt.h").
+// Blocks: The characters are Huffman coded in blocks, each with its
+//       own tree (see "HuffmanBlocks.h").
+// Runs: Like Blocks, with symbols for runs of the previous character.
+// Wide: Like Blocks, with the 16-bit values of the source as symbols.
+// Frames: Like Blocks, with one tree per byte position within frames.
+// Coders: Like Blocks, with Huffman codes or tANS, chosen per block
+//       (see "EntropyCoder.h").
+const unsigned METHOD_SIZE = 1;
+const char LZ77_METHOD = 1;
+const char BWT_METHOD = 2;
+const char BLOCK_METHOD = 3;
+const char RUN_METHOD = 4;
+const char WIDE_METHOD = 5;
+const char FRAME_METHOD = 6;
+const char CODER_METHOD = 7;
+
+// Entropy coders of the blocks of CODER_METHOD, as stored in their
+// weights (see "EntropyCoder.h"). BLOCK_METHOD always uses HUFFMAN_CODER.
+// AUTO_CODER is not stored: it chooses the coder of each block.
+const char HUFFMAN_CODER = 0;
+const char TANS_CODER = 1;
+const char AUTO_CODER = 2;
+
+// Size of the body size field of an extended header.
+const unsigned BODY_SIZE_SIZE = 8;
+
+// Every method codes the data in blocks of at most MAX_BLOCK_SIZE
+// bytes, each starting with a header of at least MIN_BLOCK_HEADER_SIZE
+// bytes. This bounds the original size a body can decode to.
+const unsigned MAX_BLOCK_SIZE = 1 << 22;
+const unsigned MIN_BLOCK_HEADER_SIZE = 12;
+
+// Sizes of the fields of a filter (see "Filter.h").
+const unsigned FILTER_TYPE_SIZE = 1;
+const unsigned FILTER_STRIDE_SIZE = 1;
+
+// Size of the id of a pre-trained static table.
+// It is used only in static table mode.
+const unsigned TABLE_ID_SIZE = 4;
+
 // Indicate the size of header-body, which is the dictionary 
 // size (the number of key-value pairs).
 // It is used only in key-value pair mode (compression mode == 0).
@@ -40,9 +111,46 @@ const unsigned CHAR_VALUE_SIZE = 1;
 const unsigned SHORT_VALUE_SIZE = 2;
 const unsigned UNSIGNED_VALUE_SIZE = 4;
 
+// Weights of an alphabet other than the 256 characters.
+// Format: [format][all values] or [format][count][count * (key, value)]
+//         or [format][count][count * (gap, value)]
+// The format byte is the value size, plus WEIGHT_PAIRS_FLAG if
+// only the (key, value) pairs of the symbols that occur are stored.
+// It is WEIGHT_VARINT_FLAG if the pairs are the number of symbols
+// skipped since the previous key, and the value, as variable-length
+// integers of 7 bits per byte. It suits large alphabets, e.g. 16-bit
+// symbols, in which most of the symbols that occur are rare.
+const unsigned WEIGHT_FORMAT_SIZE = 1;
+const char WEIGHT_PAIRS_FLAG = 0x10;
+const char WEIGHT_VARINT_FLAG = 0x20;
+const unsigned WEIGHT_COUNT_SIZE = 4;
+const unsigned SYMBOL_KEY_SIZE = 2;
+
 
 // At the end of file headder.
 // Uses 4 bytes to indicate the size of the original file.
 const unsigned ORIGINAL_SIZE = 4;
 
+// Trailer of a file holding several members, each with its own
+// header and body (see "Trailer.cpp"). It follows the last member.
+// Format: [trailer flag][number of members][member offsets][trailer size][magic]
+// The trailer size counts every field, so the trailer is found from
+// the end of the file. Member offsets are counted backwards from the
+// start of the trailer, so they stay valid when files are joined with
+// "cat". A file with a single member has no trailer.
+const char TRAILER_FLAG = (char)0xFF;
+const unsigned MEMBER_COUNT_SIZE = 4;
+const unsigned MEMBER_OFFSET_SIZE = 8;
+const unsigned TRAILER_SIZE_SIZE = 4;
+const unsigned TRAILER_MAGIC_SIZE = 4;
+const char TRAILER_MAGIC[TRAILER_MAGIC_SIZE + 1] = "HFIX";
+
+// Size of an extended header, including the original file size.
+const unsigned EXTENDED_HEADER_SIZE = BIT_FLAG + METHOD_SIZE + ORIGINAL_SIZE + BODY_SIZE_SIZE;
+const unsigned FILTERED_HEADER_SIZE = EXTENDED_HEADER_SIZE + FILTER_TYPE_SIZE + FILTER_STRIDE_SIZE;
+
+// Largest possible file header: bit flag, 256 values of 4 bytes
+// each (list mode) and the original file size.
+const unsigned MAX_HEADER_SIZE = BIT_FLAG + 256 * UNSIGNED_VALUE_SIZE + ORIGINAL_SIZE;
+
 // End of HeaderFormat.h
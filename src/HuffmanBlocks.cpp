@@ -0,0 +1,563 @@
+/*
+ * HuffmanBlocks.cpp
+ *
+ * Description: Huffman coding in blocks of 1 MB, each with its own tree.
+ *              With runs, a character repeated at least MIN_RUN more
+ *              times is followed by one run symbol and the extra bits
+ *              of the run length, in place of the repeated characters.
+ *              With wide symbols, the blocks are 4 MB of 16-bit symbols,
+ *              and an odd last byte follows the codes as 8 plain bits.
+ *              With frames, the weights start with the frame size K,
+ *              followed by the weights of the K trees. With coders, they
+ *              start with the type of the coder of the block.
+ *
+ *              Block format: [block size][table size][coded size]
+ *                            [weights][coded characters]
+ *
+ *
+ */
+
+#include <vector>
+#include <thread>
+#include <cstring>
+#include "HuffmanBlocks.h"
+#include "HuffmanTree.h"
+#include "DecodeTable.h"
+#include "BitBuffer.h"
+#include "FrequencyCounter.h"
+#include "EntropyCoder.h"
+#include "Trace.h"
+#include "HeaderFormat.h"
+
+using namespace std;
+
+// Desc: Weights of an alphabet other than the 256 characters.
+//       Implemented in "FileHeaderHandler.cpp".
+int weightsSize(const unsigned *, unsigned);
+int writeWeights(OutBitStream &, const unsigned *, unsigned);
+int parseWeights(const char *, unsigned, unsigned *, unsigned);
+
+// Desc: Codes of lengths with extra bits.
+//       Implemented in "Lz77.cpp".
+unsigned splitValue(unsigned, unsigned &, unsigned &);
+unsigned getNumOfExtraBits(unsigned);
+unsigned joinValue(unsigned, unsigned);
+
+// Number of source bytes coded with one tree. Wide blocks are larger,
+// since their weights take more room.
+static const unsigned HUFFMAN_BLOCK_SIZE = 1 << 20;
+static const unsigned WIDE_BLOCK_SIZE = 1 << 22;
+
+// The symbols are the characters, as unsigned char, then (with runs)
+// one per run length code. The codes cover every run within a block.
+static const unsigned NUM_OF_LITERALS = 256;
+static const unsigned NUM_OF_RUN_CODES = 40;
+static const unsigned NUM_OF_BLOCK_SYMBOLS = NUM_OF_LITERALS + NUM_OF_RUN_CODES;
+
+// Shortest run, not counting the character before it. Shorter runs
+// are cheaper as characters.
+static const unsigned MIN_RUN = 4;
+
+// Wide symbols are the 16-bit little-endian values of the source.
+static const unsigned NUM_OF_WIDE_SYMBOLS = 1 << 16;
+
+// Bits of the decode table of wide symbols. Their codes are longer, and
+// the larger table saves most walks on the tree.
+static const unsigned WIDE_LOOKUP_BITS = 14;
+
+// Size of the frame size field of the weights of a frame block.
+static const unsigned FRAME_SIZE_SIZE = 1;
+
+// Size of the coder field of the weights of a coder block.
+static const unsigned CODER_SIZE = 1;
+
+// Sizes of the fields of a block.
+static const unsigned BLOCK_SIZE_SIZE = 4;
+static const unsigned TABLE_SIZE_SIZE = 4;
+static const unsigned CODED_SIZE_SIZE = 4;
+static const unsigned BLOCK_HEADER_SIZE = BLOCK_SIZE_SIZE + TABLE_SIZE_SIZE + CODED_SIZE_SIZE;
+
+// Desc: One block on its way through the coder.
+class HuffmanBlock {
+public:
+	vector<char> data;			// Source bytes, or decoded bytes.
+	unsigned size;				// Number of source bytes.
+	char method;				// BLOCK_METHOD, RUN_METHOD, WIDE_METHOD, FRAME_METHOD or CODER_METHOD
+	unsigned frameSize;			// Number of trees of a frame block.
+	char coder;					// Coder of a block or coder block (see "EntropyCoder.h").
+	vector<unsigned> weights;	// Weights of the trees, one after another.
+	vector<char> coded;			// Coded characters, after the weights when decoding.
+	unsigned codedSize;
+	unsigned tableSize;			// Size of the weights when decoding.
+	char *output;				// Where the decoded bytes go.
+	bool isValid;				// The block has been decoded.
+}; // HuffmanBlock
+
+
+// Desc: Return the number of symbols of the alphabet of "method".
+static unsigned getNumOfSymbols(char method) {
+	if (method == WIDE_METHOD)
+		return NUM_OF_WIDE_SYMBOLS;
+	return method == RUN_METHOD ? NUM_OF_BLOCK_SYMBOLS : NUM_OF_LITERALS;
+} // getNumOfSymbols
+
+// Desc: Return the largest block of "method" (in bytes).
+static unsigned getBlockSize(char method) {
+	return method == WIDE_METHOD ? WIDE_BLOCK_SIZE : HUFFMAN_BLOCK_SIZE;
+} // getBlockSize
+
+
+// Encoding
+
+// Desc: Return the number of bytes equal to "c" at the start of the
+//       "size" bytes of "data". Eight bytes are compared at a time.
+static unsigned countRun(const unsigned char *data, unsigned size, unsigned char c) {
+	unsigned long long pattern = 0x0101010101010101ULL * c;
+	unsigned i = 0;
+	for (; i + 8 <= size; i += 8) {
+		unsigned long long word;
+		memcpy(&word, data + i, 8);
+		if (word != pattern)
+			break;
+	}
+	while (i < size && data[i] == c)
+		i++;
+	return i;
+} // countRun
+
+// Desc: Count and code one block of 16-bit symbols.
+static void encodeWideBlock(HuffmanBlock *block) {
+	TRACE_SCOPE("huffman block");
+	const unsigned char *data = (const unsigned char *)block -> data.data();
+	unsigned size = block -> size;
+	FrequencyCounter counter(NUM_OF_WIDE_SYMBOLS);
+	counter.countWideBlock(block -> data.data(), size / 2);
+	const unsigned *bitVector = counter.getBitVector();
+	block -> weights.assign(bitVector, bitVector + NUM_OF_WIDE_SYMBOLS);
+
+	HuffmanTree tree(block -> weights.data(), NUM_OF_WIDE_SYMBOLS);
+	const unsigned *codeTable = tree.getCodeTable();
+	const unsigned *codeLengthTable = tree.getCodeLengthTable();
+	block -> coded.resize(2 * size + 8);
+	BitBuffer buffer;
+	buffer.setDestination(block -> coded.data());
+	for (unsigned i = 0; i + 1 < size; i += 2) {
+		unsigned symbol = data[i] | data[i + 1] << 8;
+		buffer.writeCode(codeTable[symbol], codeLengthTable[symbol]);
+	}
+	if (size % 2 != 0)
+		buffer.writeCode(data[size - 1], 8);
+	buffer.flush();
+	block -> codedSize = buffer.getLength();
+} // encodeWideBlock
+
+// Desc: Count and code one block with one tree per position within
+//       a frame.
+static void encodeFrameBlock(HuffmanBlock *block) {
+	TRACE_SCOPE("huffman block");
+	const unsigned char *data = (const unsigned char *)block -> data.data();
+	unsigned size = block -> size;
+	unsigned frameSize = block -> frameSize;
+	block -> weights.assign(frameSize * NUM_OF_LITERALS, 0);
+	unsigned *weights = block -> weights.data();
+	for (unsigned i = 0, k = 0; i < size; i++) {
+		weights[k * NUM_OF_LITERALS + data[i]]++;
+		if (++k == frameSize)
+			k = 0;
+	}
+
+	// The code tables of all trees, one after another.
+	vector<unsigned> codeTables(frameSize * NUM_OF_LITERALS);
+	vector<unsigned> codeLengthTables(frameSize * NUM_OF_LITERALS);
+	for (unsigned k = 0; k < frameSize; k++) {
+		HuffmanTree tree(weights + k * NUM_OF_LITERALS, NUM_OF_LITERALS);
+		memcpy(&codeTables[k * NUM_OF_LITERALS], tree.getCodeTable(), NUM_OF_LITERALS * sizeof(unsigned));
+		memcpy(&codeLengthTables[k * NUM_OF_LITERALS], tree.getCodeLengthTable(), NUM_OF_LITERALS * sizeof(unsigned));
+	}
+
+	block -> coded.resize(4 * size + 8);
+	BitBuffer buffer;
+	buffer.setDestination(block -> coded.data());
+	for (unsigned i = 0, k = 0; i < size; i++) {
+		unsigned index = k * NUM_OF_LITERALS + data[i];
+		buffer.writeCode(codeTables[index], codeLengthTables[index]);
+		if (++k == frameSize)
+			k = 0;
+	}
+	buffer.flush();
+	block -> codedSize = buffer.getLength();
+} // encodeFrameBlock
+
+// Desc: Count one block of characters, and code it with the coder of
+//       the block, or the one that spends the fewest bits (AUTO_CODER).
+//       The coder of BLOCK_METHOD is HUFFMAN_CODER.
+static void encodeCoderBlock(HuffmanBlock *block) {
+	TRACE_SCOPE("huffman block");
+	const unsigned char *data = (const unsigned char *)block -> data.data();
+	unsigned size = block -> size;
+	block -> weights.assign(NUM_OF_LITERALS, 0);
+	for (unsigned i = 0; i < size; i++)
+		block -> weights[data[i]]++;
+
+	if (block -> coder == AUTO_CODER)
+		block -> coder = chooseCoder(block -> weights.data(), NUM_OF_LITERALS);
+	EntropyCoder coder(block -> coder, block -> weights.data(), NUM_OF_LITERALS);
+	block -> coded.resize(4 * size + 8);
+	block -> codedSize = coder.encode(data, size, block -> coded.data());
+} // encodeCoderBlock
+
+// Desc: Count and code one block. The runs of RUN_METHOD are coded
+//       here; the other methods have a function of their own.
+static void encodeBlock(HuffmanBlock *block) {
+	if (block -> method == WIDE_METHOD) {
+		encodeWideBlock(block);
+		return;
+	}
+	if (block -> method == FRAME_METHOD) {
+		encodeFrameBlock(block);
+		return;
+	}
+	if (block -> method == BLOCK_METHOD || block -> method == CODER_METHOD) {
+		encodeCoderBlock(block);
+		return;
+	}
+	TRACE_SCOPE("huffman block");
+	const unsigned char *data = (const unsigned char *)block -> data.data();
+	unsigned size = block -> size;
+	block -> weights.assign(NUM_OF_BLOCK_SYMBOLS, 0);
+	for (unsigned i = 0; i < size; i++)
+		block -> weights[data[i]]++;
+
+	// Find the runs, as (start, length) pairs. The characters of a run
+	// are not coded, so they are taken out of the weights.
+	vector<unsigned> runs;
+	unsigned numOfExtraBits, extraBits;
+	for (unsigned i = 1; i < size; ) {
+		if (data[i] != data[i - 1]) {
+			i++;
+			continue;
+		}
+		unsigned length = countRun(data + i, size - i, data[i - 1]);
+		if (length >= MIN_RUN) {
+			runs.push_back(i);
+			runs.push_back(length);
+			block -> weights[data[i - 1]] -= length;
+			block -> weights[NUM_OF_LITERALS + splitValue(length - MIN_RUN, numOfExtraBits, extraBits)]++;
+		}
+		i += length;
+	}
+
+	HuffmanTree tree(block -> weights.data(), NUM_OF_BLOCK_SYMBOLS);
+	const unsigned *codeTable = tree.getCodeTable();
+	const unsigned *codeLengthTable = tree.getCodeLengthTable();
+	block -> coded.resize(4 * size + 8);
+	BitBuffer buffer;
+	buffer.setDestination(block -> coded.data());
+	unsigned i = 0;
+	for (unsigned r = 0; r < runs.size(); r += 2) {
+		for (; i < runs[r]; i++)
+			buffer.writeCode(codeTable[data[i]], codeLengthTable[data[i]]);
+		unsigned symbol = NUM_OF_LITERALS + splitValue(runs[r + 1] - MIN_RUN, numOfExtraBits, extraBits);
+		buffer.writeCode(codeTable[symbol], codeLengthTable[symbol]);
+		buffer.writeCode(extraBits, numOfExtraBits);
+		i += runs[r + 1];
+	}
+	for (; i < size; i++)
+		buffer.writeCode(codeTable[data[i]], codeLengthTable[data[i]]);
+	buffer.flush();
+	block -> codedSize = buffer.getLength();
+} // encodeBlock
+
+// Desc: Write a coded block to "out".
+// Post: Returns the size of the block (in bytes).
+static unsigned writeBlock(OutBitStream &out, const HuffmanBlock &block) {
+	if (block.method == FRAME_METHOD) {
+		unsigned tableSize = FRAME_SIZE_SIZE;
+		for (unsigned k = 0; k < block.frameSize; k++)
+			tableSize += weightsSize(&block.weights[k * NUM_OF_LITERALS], NUM_OF_LITERALS);
+		out.writeValue(block.size, BLOCK_SIZE_SIZE);
+		out.writeValue(tableSize, TABLE_SIZE_SIZE);
+		out.writeValue(block.codedSize, CODED_SIZE_SIZE);
+		out.writeValue(block.frameSize, FRAME_SIZE_SIZE);
+		for (unsigned k = 0; k < block.frameSize; k++)
+			writeWeights(out, &block.weights[k * NUM_OF_LITERALS], NUM_OF_LITERALS);
+		out.writeBlock(block.coded.data(), block.codedSize);
+		return BLOCK_HEADER_SIZE + tableSize + block.codedSize;
+	}
+	unsigned numOfSymbols = getNumOfSymbols(block.method);
+	unsigned coderSize = block.method == CODER_METHOD ? CODER_SIZE : 0;
+	unsigned tableSize = coderSize + weightsSize(block.weights.data(), numOfSymbols);
+	out.writeValue(block.size, BLOCK_SIZE_SIZE);
+	out.writeValue(tableSize, TABLE_SIZE_SIZE);
+	out.writeValue(block.codedSize, CODED_SIZE_SIZE);
+	if (block.method == CODER_METHOD)
+		out.writeByte(block.coder);
+	writeWeights(out, block.weights.data(), numOfSymbols);
+	out.writeBlock(block.coded.data(), block.codedSize);
+	return BLOCK_HEADER_SIZE + tableSize + block.codedSize;
+} // writeBlock
+
+// Desc: Encode the rest of the source file in Huffman coded blocks, using
+//       "numOfThreads" threads, and write the body of the member to "out".
+// Post: Returns the size of the body (in bytes).
+unsigned long long encodeHuffmanBlocks(InBitStream &in, OutBitStream &out, unsigned numOfThreads, char method, 
+	unsigned frameSize, char coder, Filter *filter) {
+	TRACE_SCOPE("encode");
+	vector<HuffmanBlock> blocks;	// Only as many as the source fills.
+	unsigned blockSize = getBlockSize(method);
+	unsigned long long bodySize = 0;
+	unsigned count;
+	do {
+		// Read one block per thread, and code them together.
+		for (count = 0; count < numOfThreads; count++) {
+			if (count == blocks.size())
+				blocks.resize(count + 1);
+			HuffmanBlock &block = blocks[count];
+			block.method = method;
+			block.frameSize = frameSize;
+			block.coder = method == CODER_METHOD ? coder : HUFFMAN_CODER;
+			block.data.resize(blockSize);
+			if (filter != NULL)
+				block.size = filter -> read(in, block.data.data(), blockSize);
+			else
+				block.size = in.readBlock(block.data.data(), blockSize);
+			if (block.size == 0)
+				break;
+		}
+		if (count == 1) {
+			encodeBlock(&blocks[0]);
+		} else {
+			vector<thread> workers;
+			for (unsigned i = 0; i < count; i++)
+				workers.push_back(thread(encodeBlock, &blocks[i]));
+			for (unsigned i = 0; i < count; i++)
+				workers[i].join();
+		}
+		for (unsigned i = 0; i < count; i++)
+			bodySize += writeBlock(out, blocks[i]);
+	} while (count == numOfThreads);
+	return bodySize;
+} // encodeHuffmanBlocks
+
+
+// Decoding
+
+// Desc: Decode one block of 16-bit symbols with "table" from "reader".
+// Post: Return false if the data is not valid.
+static bool decodeWideBlock(HuffmanBlock *block, const DecodeTable &table, BitReader &reader) {
+	char *output = block -> output;
+	unsigned size = block -> size;
+	unsigned symbol;
+	for (unsigned i = 0; i + 1 < size; i += 2) {
+		if (reader.readSymbol(table, symbol) == false)
+			return false;
+		output[i] = symbol;
+		output[i + 1] = symbol >> 8;
+	}
+	if (size % 2 != 0) {
+		if (reader.readBits(8, symbol) == false)
+			return false;
+		output[size - 1] = symbol;
+	}
+	return true;
+} // decodeWideBlock
+
+// Desc: Decode one block with one tree per position within a frame.
+// Post: Return false if the data is not valid.
+static bool decodeFrameBlock(HuffmanBlock *block) {
+	const char *coded = block -> coded.data();
+	if (block -> tableSize < FRAME_SIZE_SIZE)
+		return false;
+	unsigned frameSize = (unsigned char)coded[0];
+	if (frameSize < 1 || frameSize > MAX_FRAME_SIZE)
+		return false;
+	block -> weights.resize(frameSize * NUM_OF_LITERALS);
+	unsigned offset = FRAME_SIZE_SIZE;
+	for (unsigned k = 0; k < frameSize; k++) {
+		int parsed = parseWeights(coded + offset, block -> tableSize - offset, &block -> weights[k * NUM_OF_LITERALS], NUM_OF_LITERALS);
+		if (parsed == 0)
+			return false;
+		offset += parsed;
+	}
+	if (offset != block -> tableSize)
+		return false;
+
+	// The trees outlive their decode tables.
+	vector<HuffmanTree *> trees(frameSize);
+	vector<DecodeTable *> tables(frameSize);
+	for (unsigned k = 0; k < frameSize; k++) {
+		trees[k] = new HuffmanTree(&block -> weights[k * NUM_OF_LITERALS], NUM_OF_LITERALS);
+		tables[k] = new DecodeTable(*trees[k]);
+	}
+	BitReader reader(coded + block -> tableSize, coded + block -> tableSize + block -> codedSize);
+	char *output = block -> output;
+	unsigned size = block -> size;
+	unsigned symbol;
+	bool isValid = true;
+	for (unsigned i = 0, k = 0; i < size; i++) {
+		if (reader.readSymbol(*tables[k], symbol) == false) {
+			isValid = false;
+			break;
+		}
+		output[i] = symbol;
+		if (++k == frameSize)
+			k = 0;
+	}
+	for (unsigned k = 0; k < frameSize; k++) {
+		delete tables[k];
+		delete trees[k];
+	}
+	return isValid;
+} // decodeFrameBlock
+
+// Desc: Decode one block of characters, coded with Huffman codes
+//       (BLOCK_METHOD) or with the coder at the start of its weights
+//       (CODER_METHOD).
+// Post: Return false if the data is not valid.
+static bool decodeCoderBlock(HuffmanBlock *block) {
+	const char *coded = block -> coded.data();
+	char type = HUFFMAN_CODER;
+	unsigned coderSize = 0;
+	if (block -> method == CODER_METHOD) {
+		if (block -> tableSize < CODER_SIZE)
+			return false;
+		type = coded[0];
+		if (type != HUFFMAN_CODER && type != TANS_CODER)
+			return false;
+		coderSize = CODER_SIZE;
+	}
+	block -> weights.resize(NUM_OF_LITERALS);
+	unsigned weightsSize = block -> tableSize - coderSize;
+	if (parseWeights(coded + coderSize, weightsSize, block -> weights.data(), NUM_OF_LITERALS) != (int)weightsSize)
+		return false;
+
+	// The weights count the bytes of the block.
+	unsigned long long total = 0;
+	for (unsigned i = 0; i < NUM_OF_LITERALS; i++)
+		total += block -> weights[i];
+	if (total != block -> size)
+		return false;
+
+	EntropyCoder coder(type, block -> weights.data(), NUM_OF_LITERALS);
+	return coder.decode(coded + block -> tableSize, block -> codedSize, block -> output, block -> size);
+} // decodeCoderBlock
+
+// Desc: Decode one block.
+static void decodeBlock(HuffmanBlock *block) {
+	TRACE_SCOPE("huffman block");
+	block -> isValid = false;
+	if (block -> method == FRAME_METHOD) {
+		block -> isValid = decodeFrameBlock(block);
+		return;
+	}
+	if (block -> method == BLOCK_METHOD || block -> method == CODER_METHOD) {
+		block -> isValid = decodeCoderBlock(block);
+		return;
+	}
+	unsigned numOfSymbols = getNumOfSymbols(block -> method);
+	block -> weights.resize(numOfSymbols);
+	if (parseWeights(block -> coded.data(), block -> tableSize, block -> weights.data(), numOfSymbols) != (int)block -> tableSize)
+		return;
+
+	HuffmanTree tree(block -> weights.data(), numOfSymbols);
+	DecodeTable table(tree, block -> method == WIDE_METHOD ? WIDE_LOOKUP_BITS : DecodeTable::LOOKUP_BITS);
+	BitReader reader(block -> coded.data() + block -> tableSize, block -> coded.data() + block -> tableSize + block -> codedSize);
+	if (block -> method == WIDE_METHOD) {
+		block -> isValid = decodeWideBlock(block, table, reader);
+		return;
+	}
+	char *output = block -> output;
+	unsigned size = block -> size;
+	unsigned symbol, extraBits;
+	for (unsigned i = 0; i < size; ) {
+		if (reader.readSymbol(table, symbol) == false)
+			return;
+		if (symbol < NUM_OF_LITERALS) {
+			output[i++] = symbol;
+			continue;
+		}
+
+		// A run repeats the previous character.
+		unsigned code = symbol - NUM_OF_LITERALS;
+		if (i == 0 || reader.readBits(getNumOfExtraBits(code), extraBits) == false)
+			return;
+		unsigned length = joinValue(code, extraBits) + MIN_RUN;
+		if (length > size - i)
+			return;
+		memset(output + i, output[i - 1], length);
+		i += length;
+	}
+	block -> isValid = true;
+} // decodeBlock
+
+// Desc: Decode the "bodySize" bytes of Huffman coded blocks at the
+//       current position of "in", using "numOfThreads" threads.
+// Post: Return false if the data is not valid.
+bool decodeHuffmanBlocks(InBitStream &in, unsigned long long bodySize, unsigned originalSize, char *dst,
+	OutBitStream &out, unsigned numOfThreads, char method, Filter *filter) {
+	TRACE_SCOPE("decode");
+	vector<HuffmanBlock> blocks;	// Only as many as the body holds.
+	unsigned blockSize = getBlockSize(method);
+	unsigned long long consumed = 0;
+	unsigned produced = 0;
+	while (produced < originalSize) {
+
+		// Read one block per thread.
+		unsigned count = 0;
+		unsigned end = produced;
+		while (count < numOfThreads && end < originalSize) {
+			if (count == blocks.size())
+				blocks.resize(count + 1);
+			HuffmanBlock &block = blocks[count];
+			block.method = method;
+			char header[BLOCK_HEADER_SIZE];
+			if (bodySize - consumed < BLOCK_HEADER_SIZE || in.readBlock(header, BLOCK_HEADER_SIZE) != BLOCK_HEADER_SIZE)
+				return false;
+			block.size = 0;
+			block.tableSize = 0;
+			block.codedSize = 0;
+			memcpy(&block.size, header, BLOCK_SIZE_SIZE);
+			memcpy(&block.tableSize, header + BLOCK_SIZE_SIZE, TABLE_SIZE_SIZE);
+			memcpy(&block.codedSize, header + BLOCK_SIZE_SIZE + TABLE_SIZE_SIZE, CODED_SIZE_SIZE);
+			consumed += BLOCK_HEADER_SIZE;
+			if (block.size == 0 || block.size > blockSize || block.size > originalSize - end ||
+				(unsigned long long)block.tableSize + block.codedSize > bodySize - consumed)
+				return false;
+			block.coded.resize(block.tableSize + block.codedSize);
+			if (in.readBlock(block.coded.data(), block.coded.size()) != block.coded.size())
+				return false;
+			consumed += block.coded.size();
+
+			if (dst != NULL) {
+				block.output = dst + end;
+			} else {
+				block.data.resize(block.size);
+				block.output = block.data.data();
+			}
+			end += block.size;
+			count++;
+		}
+
+		if (count == 1) {
+			decodeBlock(&blocks[0]);
+		} else {
+			vector<thread> workers;
+			for (unsigned i = 0; i < count; i++)
+				workers.push_back(thread(decodeBlock, &blocks[i]));
+			for (unsigned i = 0; i < count; i++)
+				workers[i].join();
+		}
+		for (unsigned i = 0; i < count; i++) {
+			if (blocks[i].isValid == false)
+				return false;
+			if (dst == NULL && filter != NULL)
+				filter -> write(out, blocks[i].output, blocks[i].size);
+			else if (dst == NULL)
+				out.writeBlock(blocks[i].output, blocks[i].size);
+		}
+		produced = end;
+	}
+	return consumed == bodySize;
+} // decodeHuffmanBlocks
+
+// End of HuffmanBlocks.cpp
@@ -0,0 +1,63 @@
+/*
+ * HuffmanBlocks.h
+ *
+ * Description: Huffman coding in blocks. The characters are Huffman
+ *              coded as they are, in blocks of 1 MB that each have their
+ *              own tree. It is the method of filtered data that is not
+ *              coded with --lz77 or --bwt. The blocks are independent,
+ *              so several are coded at once.
+ *
+ *              With runs (--rle), the alphabet also has symbols for
+ *              runs of the previous character, which cost a few bits
+ *              however long they are, and are decoded with memset().
+ *
+ *              With wide symbols (--symbols 16), the symbols are the
+ *              16-bit values of the source, e.g. UTF-16 text or token
+ *              IDs, so that a value is coded as one symbol rather than
+ *              as two unrelated bytes.
+ *
+ *              With frames (--frame), e.g. audio samples or fixed-size
+ *              records, each byte position within a frame of K bytes
+ *              has its own tree, and the bytes are coded with the tree
+ *              of their position modulo K.
+ *
+ *              With a choice of coders (--coder), each block is coded
+ *              with Huffman codes or tANS (see "EntropyCoder.h"), built
+ *              from the same weights, and starts with the coder used.
+ *
+ *
+ */
+
+#ifndef HUFFMANBLOCKS_H
+#define HUFFMANBLOCKS_H
+
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "Filter.h"
+
+// Largest frame size of the frame method, in bytes.
+const unsigned MAX_FRAME_SIZE = 32;
+
+// Desc: Encode the rest of the source file in Huffman coded blocks, using
+//       "numOfThreads" threads, and write the body of the member to "out".
+//       "method" is BLOCK_METHOD, RUN_METHOD (with runs), WIDE_METHOD
+//       (16-bit symbols), FRAME_METHOD (one tree per position within
+//       frames of "frameSize" bytes) or CODER_METHOD (blocks coded with
+//       "coder", AUTO_CODER to choose per block). The source is read
+//       through "filter" if it is not NULL.
+// Post: Returns the size of the body (in bytes).
+unsigned long long encodeHuffmanBlocks(InBitStream &in, OutBitStream &out, unsigned numOfThreads, char method, 
+	unsigned frameSize, char coder, Filter *filter);
+
+// Desc: Decode the "bodySize" bytes of Huffman coded blocks at the
+//       current position of "in", using "numOfThreads" threads, coded
+//       with "method". The "originalSize" decoded bytes are written to
+//       "dst" if it is not NULL, otherwise to "out" (through "filter" if
+//       it is not NULL).
+// Post: Return false if the data is not valid.
+bool decodeHuffmanBlocks(InBitStream &in, unsigned long long bodySize, unsigned originalSize, char *dst,
+	OutBitStream &out, unsigned numOfThreads, char method, Filter *filter);
+
+#endif
+
+// End of HuffmanBlocks.h
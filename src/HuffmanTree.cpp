@@ -36,8 +36,8 @@ void HuffmanTree::generateCode(HuffmanTreeNode *tree, int direction) {
 
 	// Update the code tables.
 	if (tree -> type == char_node) {
-		codeTable[tree -> character + 128] = tree -> code;
-		codeLengthTable[tree -> character + 128] = tree -> codeLength;
+		codeTable[tree -> symbol] = tree -> code;
+		codeLengthTable[tree -> symbol] = tree -> codeLength;
 	}
 
 	// Generate code recursively.
@@ -123,27 +123,46 @@ void HuffmanTree::display(HuffmanTreeNode *tree, bool drawBranch[]) const {
 } // display
 
 
+// Desc: Allocate code tables for "numOfSymbols" symbols.
+void HuffmanTree::initTables(unsigned numOfSymbols) {
+	this -> numOfSymbols = numOfSymbols;
+	codeTable = new unsigned[numOfSymbols];
+	codeLengthTable = new unsigned[numOfSymbols];
+	for (unsigned i = 0; i < numOfSymbols; i++) {
+		codeTable[i] = 0;
+		codeLengthTable[i] = 0;
+	}
+} // initTables
+
+
 // Public interfaces
 
 // Desc: Constructor
 HuffmanTree::HuffmanTree() {
 	root = NULL;
-	codeTable = new unsigned[256];
-	codeLengthTable = new unsigned[256];
-	for (int i = 0; i < 256; i++) {
-		codeTable[i] = 0;
-		codeLengthTable[i] = 0;
-	}
+	initTables(256);
 } // Constructor
 
 // Desc: Non-default constructor
-HuffmanTree::HuffmanTree(PriorityQueue &pq) {
+//  Pre: The symbols of the leaves in "pq" are below "numOfSymbols".
+HuffmanTree::HuffmanTree(PriorityQueue &pq, unsigned numOfSymbols) {
 	root = NULL;
-	codeTable = new unsigned[256];
-	codeLengthTable = new unsigned[256];
-	for (int i = 0; i < 256; i++) {
-		codeTable[i] = 0;
-		codeLengthTable[i] = 0;
+	initTables(numOfSymbols);
+	createTree(pq);
+} // Non-default constructor
+
+// Desc: Non-default constructor
+//       The tree of the "numOfSymbols" symbols with the given weights,
+//       e.g. the literals and lengths of the LZ77 method.
+HuffmanTree::HuffmanTree(const unsigned *weights, unsigned numOfSymbols) {
+	root = NULL;
+	initTables(numOfSymbols);
+	PriorityQueue pq(numOfSymbols);
+	for (unsigned i = 0; i < numOfSymbols; i++) {
+		if (weights[i] != 0) {
+			HuffmanTreeNode *nodePtr = new HuffmanTreeNode(weights[i], i);
+			pq.enqueue(nodePtr);
+		}
 	}
 	createTree(pq);
 } // Non-default constructor
@@ -155,6 +174,11 @@ HuffmanTree::~HuffmanTree() {
 	delete [] codeLengthTable;
 } // Destructor
 
+// Desc: Return the number of entries of the code tables.
+unsigned HuffmanTree::getNumOfSymbols() const {
+	return numOfSymbols;
+} // getNumOfSymbols
+
 // Desc: Return the pointer of the code table.
 unsigned *HuffmanTree::getCodeTable() const {
 	return codeTable;
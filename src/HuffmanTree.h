@@ -16,9 +16,13 @@
 class HuffmanTree {
 private:
 	HuffmanTreeNode *root;			// root
+	unsigned numOfSymbols;			// Size of the code tables.
 	unsigned *codeTable;
 	unsigned *codeLengthTable;
 
+	// Desc: Allocate code tables for "numOfSymbols" symbols.
+	void initTables(unsigned numOfSymbols);
+
 	// Helper function
 
 	// Desc: Traverse the Huffman tree and generate code for each node.
@@ -37,10 +41,16 @@ private:
 public:
 
 	// Constructors and destructor
+	//       The code tables are indexed by the "symbol" of the leaves:
+	//       "character + 128" for the 256 characters by default.
 	HuffmanTree();
-	HuffmanTree(PriorityQueue &pq);
+	HuffmanTree(PriorityQueue &pq, unsigned numOfSymbols = 256);
+	HuffmanTree(const unsigned *weights, unsigned numOfSymbols);
 	~HuffmanTree();
 
+	// Desc: Return the number of entries of the code tables.
+	unsigned getNumOfSymbols() const;
+
 	// Desc: Return the pointer of the code table.
 	unsigned *getCodeTable() const;
 
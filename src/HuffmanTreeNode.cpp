@@ -16,6 +16,7 @@ using namespace std;
 // Desc: Default constructor
 HuffmanTreeNode::HuffmanTreeNode() {
 	weight = 0;
+	symbol = 0;
 	code = 0;
 	codeLength = 0;
 	lChild = NULL;
@@ -28,6 +29,22 @@ HuffmanTreeNode::HuffmanTreeNode(NodeType type, unsigned weight, char character)
 	this -> type = type;
 	this -> weight = weight;
 	this -> character = character;
+	this -> symbol = character + 128;
+	code = 0;
+	codeLength = 0;
+	lChild = NULL;
+	rChild = NULL;
+	parent = NULL;
+} // Non-default constructor
+
+// Desc: Non-default constructor
+//       Leaf of a tree over an alphabet of any size. "symbol" indexes
+//       the code tables.
+HuffmanTreeNode::HuffmanTreeNode(unsigned weight, unsigned symbol) {
+	this -> type = char_node;
+	this -> weight = weight;
+	this -> character = (char)symbol;
+	this -> symbol = symbol;
 	code = 0;
 	codeLength = 0;
 	lChild = NULL;
@@ -39,6 +56,7 @@ HuffmanTreeNode::HuffmanTreeNode(NodeType type, unsigned weight, char character)
 HuffmanTreeNode::HuffmanTreeNode(NodeType type, unsigned weight, HuffmanTreeNode *left, HuffmanTreeNode *right, HuffmanTreeNode *parent) {
 	code = 0;
 	codeLength = 0;
+	symbol = 0;
 	this -> type = type;
 	this -> weight = weight;
 
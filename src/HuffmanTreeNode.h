@@ -28,12 +28,14 @@ public:
 	HuffmanTreeNode *lChild, *rChild, *parent;
 
 	char character;
+	unsigned symbol;		// Index in the code tables.
 	unsigned code;
 	unsigned codeLength;	// Length of code
 
 	// Constructors
 	HuffmanTreeNode();
 	HuffmanTreeNode(NodeType type, unsigned weight, char character);
+	HuffmanTreeNode(unsigned weight, unsigned symbol);
 	HuffmanTreeNode(NodeType type, unsigned weight, HuffmanTreeNode *left, HuffmanTreeNode *right, HuffmanTreeNode *parent);
 
 	// Desc:  Comparators
@@ -79,9 +79,22 @@ unsigned InBitStream::readValue(const unsigned valueSize) {
 } // readValue
 
 
+// Desc: Read up to "size" bytes from the file into "data".
+// Post: Returns the number of bytes read, 0 at the end of file.
+unsigned InBitStream::readBlock(char *data, const unsigned size) {
+	if (!fin)
+		return 0;
+	fin.read(data, size);
+	unsigned numOfBytes = fin.gcount();
+	fileSize += numOfBytes;
+	return numOfBytes;
+} // readBlock
+
+
 // Desc: Move the file pointer to the given position.
 // Post: The file pointer is "offset" bytes away from the beginning of the file.
-void InBitStream::gotoPos(const unsigned offset) {
+void InBitStream::gotoPos(const unsigned long long offset) {
+	fin.clear();	// The end of file may have been reached.
 	fin.seekg(offset, ios::beg);
 } // gotoPos
 
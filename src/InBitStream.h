@@ -41,9 +41,13 @@ public:
 	//  Pre: File is not empty.
 	unsigned readValue(const unsigned valueSize);
 
+	// Desc: Read up to "size" bytes from the file into "data".
+	// Post: Returns the number of bytes read, 0 at the end of file.
+	unsigned readBlock(char *data, const unsigned size);
+
 	// Desc: Move the file pointer to the given position.
 	// Post: The file pointer is "offset" bytes away from the beginning of the file.
-	void gotoPos(const unsigned offset);
+	void gotoPos(const unsigned long long offset);
 
 	// Desc: Return the value in buffer.
 	char getCharacter() const;
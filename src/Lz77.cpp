@@ -0,0 +1,446 @@
+/*
+ * Lz77.cpp
+ *
+ * Description: LZ77 method. Strings that occurred within the last
+ *              "window" bytes are replaced by (length, distance) pairs,
+ *              found with hash chains. The literals and the lengths
+ *              share one Huffman tree of 272 symbols, and the distances
+ *              use a second tree of 48 symbols. Both are built per block
+ *              of 1 MB, while matches may reach back into earlier blocks.
+ *
+ *              Body format: [window bits][blocks]
+ *              Block format: [block size][table size][coded size]
+ *                            [literal / length weights][distance weights]
+ *                            [coded tokens]
+ *
+ *
+ */
+
+#include <vector>
+#include <cstring>
+#include "Lz77.h"
+#include "HuffmanTree.h"
+#include "DecodeTable.h"
+#include "BitBuffer.h"
+#include "HeaderFormat.h"
+#include "Trace.h"
+
+using namespace std;
+
+// Desc: Weights of an alphabet other than the 256 characters.
+//       Implemented in "FileHeaderHandler.cpp".
+int weightsSize(const unsigned *, unsigned);
+int writeWeights(OutBitStream &, const unsigned *, unsigned);
+int parseWeights(const char *, unsigned, unsigned *, unsigned);
+
+// Shortest and longest match, in bytes.
+static const unsigned MIN_MATCH = 3;
+static const unsigned MAX_MATCH = 258;
+
+// Symbols of the first tree: the 256 literals, then one per length code.
+static const unsigned NUM_OF_LITERALS = 256;
+static const unsigned NUM_OF_LENGTH_CODES = 16;
+static const unsigned NUM_OF_LITERAL_SYMBOLS = NUM_OF_LITERALS + NUM_OF_LENGTH_CODES;
+
+// Symbols of the second tree: one per distance code.
+static const unsigned NUM_OF_DISTANCE_SYMBOLS = 48;
+
+// Number of source bytes coded with one pair of trees.
+static const unsigned LZ77_BLOCK_SIZE = 1 << 20;
+
+// Sizes of the fields of a block.
+static const unsigned BLOCK_SIZE_SIZE = 4;
+static const unsigned TABLE_SIZE_SIZE = 4;
+static const unsigned CODED_SIZE_SIZE = 4;
+static const unsigned BLOCK_HEADER_SIZE = BLOCK_SIZE_SIZE + TABLE_SIZE_SIZE + CODED_SIZE_SIZE;
+
+// Size of the window bits field at the start of the body.
+static const unsigned WINDOW_BITS_SIZE = 1;
+
+// Match finder: size of the hash table (in bits), candidates tried
+// per position, and the match length from which the next position
+// is not tried as well (lazy matching).
+static const unsigned HASH_BITS = 16;
+static const unsigned MAX_CHAIN = 64;
+static const unsigned LAZY_LIMIT = 32;
+
+// A match of MIN_MATCH bytes further back than this usually takes
+// more bits than its literals, so it is not used.
+static const unsigned TOO_FAR = 4096;
+
+// Desc: Split "value" into a code and "numOfExtraBits" extra bits.
+//       Values 0 and 1 have codes of their own. Larger values are
+//       grouped by their highest bit and the bit below it, so code
+//       2 * b + x covers the 2^(b - 1) values starting at (2 + x) << (b - 1).
+//       Also used for the runs of "HuffmanBlocks.cpp".
+// Post: Returns the code.
+unsigned splitValue(unsigned value, unsigned &numOfExtraBits, unsigned &extraBits) {
+	if (value < 2) {
+		numOfExtraBits = 0;
+		extraBits = 0;
+		return value;
+	}
+	unsigned highestBit = 1;
+	while ((value >> (highestBit + 1)) != 0)
+		highestBit++;
+	numOfExtraBits = highestBit - 1;
+	extraBits = value & ((1u << numOfExtraBits) - 1);
+	return 2 * highestBit + ((value >> numOfExtraBits) & 1);
+} // splitValue
+
+// Desc: Return the number of extra bits following "code".
+unsigned getNumOfExtraBits(unsigned code) {
+	return code < 2 ? 0 : (code >> 1) - 1;
+} // getNumOfExtraBits
+
+// Desc: Return the value of "code" and its extra bits.
+unsigned joinValue(unsigned code, unsigned extraBits) {
+	if (code < 2)
+		return code;
+	return ((2 | (code & 1)) << getNumOfExtraBits(code)) | extraBits;
+} // joinValue
+
+// Desc: A literal (length 0) or a match.
+class Token {
+public:
+	unsigned length;
+	unsigned distance;		// The literal if "length" is 0.
+}; // Token
+
+// Desc: Finds the longest earlier occurrence of the string at a given
+//       position. "buffer" holds the window and the current block.
+//       The positions with the same hash of their first 3 bytes are
+//       chained, most recent first: "head" gives the last one (plus 1,
+//       0 if none) and "prev" the one before each position.
+class MatchFinder {
+private:
+	unsigned windowSize;
+	vector<unsigned> head;
+	vector<unsigned> prev;			// Indexed by position % windowSize.
+	unsigned nextInsert;			// First position not in the chains.
+
+	// Desc: Return the hash of the 3 bytes at "data".
+	static unsigned hash(const char *data) {
+		unsigned value = ((unsigned)(unsigned char)data[0] << 16) |
+			((unsigned)(unsigned char)data[1] << 8) | (unsigned char)data[2];
+		return (value * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+public:
+	vector<char> buffer;
+	unsigned start;					// Position of buffer[0].
+	unsigned end;					// Position after the loaded data.
+
+	// Constructor
+	MatchFinder(unsigned windowSize) : windowSize(windowSize), head(1 << HASH_BITS, 0), prev(windowSize, 0) {
+		unsigned capacity = 2 * (windowSize > LZ77_BLOCK_SIZE ? windowSize : LZ77_BLOCK_SIZE);
+		buffer.resize(capacity);
+		nextInsert = 0;
+		start = 0;
+		end = 0;
+	}
+
+	// Desc: Read the next block of the source file after the loaded data,
+	//       through "filter" if it is not NULL. The last "windowSize"
+	//       bytes are kept in front of it.
+	// Post: Returns the size of the block, 0 at the end of file.
+	unsigned load(InBitStream &in, Filter *filter) {
+		unsigned filled = end - start;
+		if (filled + LZ77_BLOCK_SIZE > buffer.size()) {
+			unsigned keep = filled < windowSize ? filled : windowSize;
+			memmove(buffer.data(), buffer.data() + filled - keep, keep);
+			start = end - keep;
+			filled = keep;
+		}
+		unsigned size;
+		if (filter != NULL)
+			size = filter -> read(in, buffer.data() + filled, LZ77_BLOCK_SIZE);
+		else
+			size = in.readBlock(buffer.data() + filled, LZ77_BLOCK_SIZE);
+		end += size;
+		return size;
+	}
+
+	// Desc: Add the positions before "limit" to the chains.
+	//       The last two loaded bytes wait for the next block.
+	void insertUpTo(unsigned limit) {
+		for (; nextInsert < limit && nextInsert + 2 < end; nextInsert++) {
+			unsigned h = hash(buffer.data() + (nextInsert - start));
+			prev[nextInsert & (windowSize - 1)] = head[h];
+			head[h] = nextInsert + 1;
+		}
+	}
+
+	// Desc: Find the longest match of the string at "pos", at most
+	//       MAX_MATCH bytes and within the loaded data.
+	//  Pre: The positions before "pos" are in the chains.
+	// Post: Returns its length (0 if shorter than MIN_MATCH), and its
+	//       distance in "distance".
+	unsigned findMatch(unsigned pos, unsigned &distance) const {
+		unsigned maxLength = end - pos < MAX_MATCH ? end - pos : MAX_MATCH;
+		if (maxLength < MIN_MATCH)
+			return 0;
+
+		const char *current = buffer.data() + (pos - start);
+		unsigned bestLength = 0;
+		unsigned candidate = head[hash(current)];
+		for (unsigned chain = 0; candidate != 0 && chain < MAX_CHAIN; chain++) {
+			unsigned match = candidate - 1;
+			if (match >= pos || pos - match >= windowSize)
+				break;
+			const char *reference = buffer.data() + (match - start);
+			if (reference[bestLength] == current[bestLength]) {
+				unsigned length = 0;
+				while (length < maxLength && reference[length] == current[length])
+					length++;
+				if (length > bestLength && (length > MIN_MATCH || pos - match <= TOO_FAR)) {
+					bestLength = length;
+					distance = pos - match;
+					if (length == maxLength)
+						break;
+				}
+			}
+
+			// The chain only goes back in time. A larger position
+			// means that the slot has been reused.
+			candidate = prev[match & (windowSize - 1)];
+			if (candidate > match)
+				break;
+		}
+		return bestLength >= MIN_MATCH ? bestLength : 0;
+	}
+
+}; // MatchFinder
+
+// Desc: Code the tokens of one block, "blockSize" source bytes, and
+//       write the block to "out".
+// Post: Returns the size of the block (in bytes).
+static unsigned writeBlock(OutBitStream &out, const vector<Token> &tokens, unsigned blockSize, vector<char> &coded) {
+	unsigned literalWeights[NUM_OF_LITERAL_SYMBOLS] = {0};
+	unsigned distanceWeights[NUM_OF_DISTANCE_SYMBOLS] = {0};
+	unsigned numOfExtraBits, extraBits;
+	for (unsigned i = 0; i < tokens.size(); i++) {
+		if (tokens[i].length == 0) {
+			literalWeights[tokens[i].distance]++;
+		} else {
+			literalWeights[NUM_OF_LITERALS + splitValue(tokens[i].length - MIN_MATCH, numOfExtraBits, extraBits)]++;
+			distanceWeights[splitValue(tokens[i].distance - 1, numOfExtraBits, extraBits)]++;
+		}
+	}
+
+	HuffmanTree *literalTree = new HuffmanTree(literalWeights, NUM_OF_LITERAL_SYMBOLS);
+	HuffmanTree *distanceTree = new HuffmanTree(distanceWeights, NUM_OF_DISTANCE_SYMBOLS);
+	const unsigned *literalCodes = literalTree -> getCodeTable();
+	const unsigned *literalLengths = literalTree -> getCodeLengthTable();
+	const unsigned *distanceCodes = distanceTree -> getCodeTable();
+	const unsigned *distanceLengths = distanceTree -> getCodeLengthTable();
+
+	// A literal takes at most 4 bytes, and so do 3 bytes matched.
+	coded.resize(4 * blockSize + 8);
+	BitBuffer buffer;
+	buffer.setDestination(coded.data());
+	for (unsigned i = 0; i < tokens.size(); i++) {
+		if (tokens[i].length == 0) {
+			buffer.writeCode(literalCodes[tokens[i].distance], literalLengths[tokens[i].distance]);
+		} else {
+			unsigned symbol = NUM_OF_LITERALS + splitValue(tokens[i].length - MIN_MATCH, numOfExtraBits, extraBits);
+			buffer.writeCode(literalCodes[symbol], literalLengths[symbol]);
+			buffer.writeCode(extraBits, numOfExtraBits);
+			symbol = splitValue(tokens[i].distance - 1, numOfExtraBits, extraBits);
+			buffer.writeCode(distanceCodes[symbol], distanceLengths[symbol]);
+			buffer.writeCode(extraBits, numOfExtraBits);
+		}
+	}
+	buffer.flush();
+	delete literalTree;
+	delete distanceTree;
+
+	unsigned tableSize = weightsSize(literalWeights, NUM_OF_LITERAL_SYMBOLS) +
+		weightsSize(distanceWeights, NUM_OF_DISTANCE_SYMBOLS);
+	out.writeValue(blockSize, BLOCK_SIZE_SIZE);
+	out.writeValue(tableSize, TABLE_SIZE_SIZE);
+	out.writeValue(buffer.getLength(), CODED_SIZE_SIZE);
+	writeWeights(out, literalWeights, NUM_OF_LITERAL_SYMBOLS);
+	writeWeights(out, distanceWeights, NUM_OF_DISTANCE_SYMBOLS);
+	out.writeBlock(coded.data(), buffer.getLength());
+	return BLOCK_HEADER_SIZE + tableSize + buffer.getLength();
+} // writeBlock
+
+// Desc: Encode the rest of the source file with the LZ77 method and write
+//       the body of the member to "out". The source is read through
+//       "filter" if it is not NULL.
+//  Pre: "windowSize" is a power of two between MIN_LZ77_WINDOW and
+//       MAX_LZ77_WINDOW.
+// Post: Returns the size of the body (in bytes).
+unsigned long long encodeLz77(InBitStream &in, OutBitStream &out, unsigned windowSize, Filter *filter) {
+	TRACE_SCOPE("encode");
+	unsigned windowBits = 0;
+	while ((1u << windowBits) < windowSize)
+		windowBits++;
+	out.writeByte(windowBits);
+	unsigned long long bodySize = WINDOW_BITS_SIZE;
+
+	MatchFinder finder(windowSize);
+	vector<Token> tokens;
+	vector<char> coded;
+	tokens.reserve(LZ77_BLOCK_SIZE);
+	unsigned blockSize;
+	while ((blockSize = finder.load(in, filter)) > 0) {
+		TRACE_SCOPE("block");
+		tokens.clear();
+		unsigned pos = finder.end - blockSize;
+		while (pos < finder.end) {
+			Token token;
+			finder.insertUpTo(pos);
+			token.length = finder.findMatch(pos, token.distance);
+
+			// Lazy matching: a longer match at the next position
+			// is worth a literal.
+			if (token.length != 0 && token.length < LAZY_LIMIT) {
+				Token next;
+				finder.insertUpTo(pos + 1);
+				next.length = finder.findMatch(pos + 1, next.distance);
+				if (next.length > token.length) {
+					Token literal;
+					literal.length = 0;
+					literal.distance = (unsigned char)finder.buffer[pos - finder.start];
+					tokens.push_back(literal);
+					pos++;
+					token = next;
+				}
+			}
+
+			if (token.length == 0) {
+				token.distance = (unsigned char)finder.buffer[pos - finder.start];
+				pos++;
+			} else {
+				pos += token.length;
+			}
+			tokens.push_back(token);
+		}
+		bodySize += writeBlock(out, tokens, blockSize, coded);
+	}
+	return bodySize;
+} // encodeLz77
+
+// Desc: Decode the tokens of one block, "blockSize" bytes, to "window"
+//       at "pos". The bytes before "pos" are the previous ones.
+// Post: Return false if the data is not valid.
+static bool decodeBlock(BitReader &reader, const DecodeTable &literalTable, const DecodeTable &distanceTable,
+	char *window, unsigned pos, unsigned blockSize) {
+	unsigned blockEnd = pos + blockSize;
+	unsigned symbol, extraBits;
+	while (pos < blockEnd) {
+		if (reader.readSymbol(literalTable, symbol) == false)
+			return false;
+		if (symbol < NUM_OF_LITERALS) {
+			window[pos++] = (char)symbol;
+			continue;
+		}
+
+		unsigned code = symbol - NUM_OF_LITERALS;
+		if (reader.readBits(getNumOfExtraBits(code), extraBits) == false)
+			return false;
+		unsigned length = joinValue(code, extraBits) + MIN_MATCH;
+		if (reader.readSymbol(distanceTable, code) == false ||
+			reader.readBits(getNumOfExtraBits(code), extraBits) == false)
+			return false;
+		unsigned distance = joinValue(code, extraBits) + 1;
+		if (length > blockEnd - pos || distance > pos)
+			return false;
+
+		// The match may overlap the bytes it produces.
+		const char *reference = window + pos - distance;
+		if (distance >= length) {
+			memcpy(window + pos, reference, length);
+		} else {
+			for (unsigned i = 0; i < length; i++)
+				window[pos + i] = reference[i];
+		}
+		pos += length;
+	}
+	return true;
+} // decodeBlock
+
+// Desc: Decode the "bodySize" bytes of LZ77 coded data at the current
+//       position of "in". The "originalSize" decoded bytes are written
+//       to "dst" if it is not NULL (which then also serves as the
+//       window), otherwise to "out" (through "filter" if it is not NULL).
+// Post: Return false if the data is not valid.
+bool decodeLz77(InBitStream &in, unsigned long long bodySize, unsigned originalSize, char *dst,
+	OutBitStream &out, Filter *filter) {
+	TRACE_SCOPE("decode");
+	unsigned char windowBits;
+	if (bodySize < WINDOW_BITS_SIZE || in.readBlock((char *)&windowBits, WINDOW_BITS_SIZE) != WINDOW_BITS_SIZE)
+		return false;
+	if (windowBits < MIN_LZ77_WINDOW_BITS || windowBits > MAX_LZ77_WINDOW_BITS)
+		return false;
+	unsigned windowSize = 1u << windowBits;
+	unsigned long long consumed = WINDOW_BITS_SIZE;
+
+	// Without a destination in memory, the window is kept in a buffer
+	// of its own, and "start" is the position of its first byte.
+	vector<char> buffer;
+	if (dst == NULL)
+		buffer.resize(2 * (windowSize > LZ77_BLOCK_SIZE ? windowSize : LZ77_BLOCK_SIZE));
+	char *window = dst != NULL ? dst : buffer.data();
+	unsigned start = 0;
+
+	vector<char> block;
+	unsigned literalWeights[NUM_OF_LITERAL_SYMBOLS];
+	unsigned distanceWeights[NUM_OF_DISTANCE_SYMBOLS];
+	unsigned produced = 0;
+	while (produced < originalSize) {
+		TRACE_SCOPE("block");
+		char header[BLOCK_HEADER_SIZE];
+		if (bodySize - consumed < BLOCK_HEADER_SIZE || in.readBlock(header, BLOCK_HEADER_SIZE) != BLOCK_HEADER_SIZE)
+			return false;
+		unsigned blockSize = 0, tableSize = 0, codedSize = 0;
+		memcpy(&blockSize, header, BLOCK_SIZE_SIZE);
+		memcpy(&tableSize, header + BLOCK_SIZE_SIZE, TABLE_SIZE_SIZE);
+		memcpy(&codedSize, header + BLOCK_SIZE_SIZE + TABLE_SIZE_SIZE, CODED_SIZE_SIZE);
+		consumed += BLOCK_HEADER_SIZE;
+		if (blockSize == 0 || blockSize > LZ77_BLOCK_SIZE || blockSize > originalSize - produced ||
+			(unsigned long long)tableSize + codedSize > bodySize - consumed)
+			return false;
+		block.resize(tableSize + codedSize);
+		if (in.readBlock(block.data(), block.size()) != block.size())
+			return false;
+		consumed += block.size();
+
+		int literalSize = parseWeights(block.data(), tableSize, literalWeights, NUM_OF_LITERAL_SYMBOLS);
+		int distanceSize = literalSize == 0 ? 0 :
+			parseWeights(block.data() + literalSize, tableSize - literalSize, distanceWeights, NUM_OF_DISTANCE_SYMBOLS);
+		if (distanceSize == 0 || (unsigned)(literalSize + distanceSize) != tableSize)
+			return false;
+
+		// Keep the last "windowSize" bytes in front of the buffer.
+		if (dst == NULL && produced - start + blockSize > buffer.size()) {
+			unsigned keep = produced - start < windowSize ? produced - start : windowSize;
+			memmove(window, window + (produced - start) - keep, keep);
+			start = produced - keep;
+		}
+
+		HuffmanTree *literalTree = new HuffmanTree(literalWeights, NUM_OF_LITERAL_SYMBOLS);
+		HuffmanTree *distanceTree = new HuffmanTree(distanceWeights, NUM_OF_DISTANCE_SYMBOLS);
+		bool isValid;
+		{
+			DecodeTable literalTable(*literalTree), distanceTable(*distanceTree);
+			BitReader reader(block.data() + tableSize, block.data() + block.size());
+			isValid = decodeBlock(reader, literalTable, distanceTable, window, produced - start, blockSize);
+		}
+		delete literalTree;
+		delete distanceTree;
+		if (isValid == false)
+			return false;
+
+		if (dst == NULL && filter != NULL)
+			filter -> write(out, window + (produced - start), blockSize);
+		else if (dst == NULL)
+			out.writeBlock(window + (produced - start), blockSize);
+		produced += blockSize;
+	}
+	return consumed == bodySize;
+} // decodeLz77
+
+// End of Lz77.cpp
@@ -0,0 +1,45 @@
+/*
+ * Lz77.h
+ *
+ * Description: LZ77 method. Strings that occurred within the last
+ *              "window" bytes are replaced by (length, distance) pairs,
+ *              found with hash chains. The literals and the lengths
+ *              share one Huffman tree of 272 symbols, and the distances
+ *              use a second tree of 48 symbols. Both are built per block
+ *              of 1 MB, while matches may reach back into earlier blocks.
+ *
+ *
+ */
+
+#ifndef LZ77_H
+#define LZ77_H
+
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "Filter.h"
+
+// Smallest and largest window, in bytes, and their numbers of bits.
+const unsigned MIN_LZ77_WINDOW_BITS = 10;
+const unsigned MAX_LZ77_WINDOW_BITS = 24;
+const unsigned MIN_LZ77_WINDOW = 1 << MIN_LZ77_WINDOW_BITS;
+const unsigned MAX_LZ77_WINDOW = 1 << MAX_LZ77_WINDOW_BITS;
+
+// Desc: Encode the rest of the source file with the LZ77 method and write
+//       the body of the member to "out". The source is read through
+//       "filter" if it is not NULL.
+//  Pre: "windowSize" is a power of two between MIN_LZ77_WINDOW and
+//       MAX_LZ77_WINDOW.
+// Post: Returns the size of the body (in bytes).
+unsigned long long encodeLz77(InBitStream &in, OutBitStream &out, unsigned windowSize, Filter *filter);
+
+// Desc: Decode the "bodySize" bytes of LZ77 coded data at the current
+//       position of "in". The "originalSize" decoded bytes are written
+//       to "dst" if it is not NULL (which then also serves as the
+//       window), otherwise to "out" (through "filter" if it is not NULL).
+// Post: Return false if the data is not valid.
+bool decodeLz77(InBitStream &in, unsigned long long bodySize, unsigned originalSize, char *dst,
+	OutBitStream &out, Filter *filter);
+
+#endif
+
+// End of Lz77.h
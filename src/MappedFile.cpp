@@ -0,0 +1,148 @@
+/*
+ * MappedFile.cpp
+ *
+ * Description: Destination file mapped into memory (Linux only). The
+ *              final size is known before coding, so the file is
+ *              allocated at once and the data is written straight into
+ *              the mapping, without write calls or seeking back.
+ *
+ *
+ */
+
+#include <cstddef>
+#include "MappedFile.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+// Desc: Constructor
+MappedFile::MappedFile() {
+	fd = -1;
+	data = NULL;
+	size = 0;
+} // Constructor
+
+// Desc: Destructor
+MappedFile::~MappedFile() {
+	unmap();
+} // Destructor
+
+// Desc: Set the size of the open file and map it.
+// Post: Return false if it fails. The file stays open.
+bool MappedFile::setSize(unsigned long long size) {
+#ifdef __linux__
+	// Allocate the blocks in one extent where the file system supports
+	// it. Then set the exact size, which also cuts the data of an older file.
+	// Any other failure (e.g. a full disk) is reported, not found later
+	// as a fault on a page of the mapping.
+	if (fallocate(fd, 0, 0, size) != 0 && errno != EOPNOTSUPP && errno != ENOSYS)
+		return false;
+	if (ftruncate(fd, size) != 0)
+		return false;
+
+	this -> size = size;
+	if (size == 0)
+		return true;	// An empty mapping is not allowed.
+	void *address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED) {
+		this -> size = 0;
+		return false;
+	}
+	madvise(address, size, MADV_SEQUENTIAL);
+	data = (char *)address;
+	return true;
+#else
+	return false;
+#endif
+} // setSize
+
+// Desc: Return true if "fileName" is a regular file, or does not
+//       exist yet (map() then creates one).
+bool MappedFile::isRegularFile(const char *fileName) {
+#ifdef __linux__
+	struct stat info;
+	if (stat(fileName, &info) != 0)
+		return errno == ENOENT;
+	return S_ISREG(info.st_mode);
+#else
+	return false;
+#endif
+} // isRegularFile
+
+// Desc: Open "fileName" (created if needed), make it exactly "size"
+//       bytes long with its blocks allocated up front, and map it.
+//       The first bytes already in the file are kept.
+// Post: Return false if the file cannot be mapped (e.g. not on Linux).
+//       Nothing is mapped then, the file has its old size again, and
+//       the caller writes the file normally.
+bool MappedFile::map(const char *fileName, unsigned long long size) {
+	unmap();
+#ifdef __linux__
+	fd = open(fileName, O_RDWR | O_CREAT, 0666);
+	if (fd == -1)
+		return false;
+	off_t oldSize = lseek(fd, 0, SEEK_END);
+	if (setSize(size) == false) {
+		if (oldSize != -1)
+			ftruncate(fd, oldSize);
+		unmap();
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+} // map
+
+// Desc: Change the size of the mapped file, e.g. to add more data.
+//       The data in the first "size" bytes is kept, but the address
+//       of the mapping may change.
+//  Pre: isMapped() is true.
+// Post: Return false if the file cannot be resized.
+bool MappedFile::resize(unsigned long long size) {
+#ifdef __linux__
+	if (data != NULL)
+		munmap(data, this -> size);
+	data = NULL;
+	this -> size = 0;
+#endif
+	return setSize(size);
+} // resize
+
+// Desc: Return true if a file is mapped.
+bool MappedFile::isMapped() const {
+	return fd != -1;
+} // isMapped
+
+// Desc: Return the mapped data (NULL if the file is empty).
+//  Pre: isMapped() is true.
+char *MappedFile::getData() const {
+	return data;
+} // getData
+
+// Desc: Return the size of the mapped file.
+unsigned long long MappedFile::getSize() const {
+	return size;
+} // getSize
+
+// Desc: Unmap and close the file.
+void MappedFile::unmap() {
+#ifdef __linux__
+	if (data != NULL)
+		munmap(data, size);
+	if (fd != -1)
+		close(fd);
+#endif
+	fd = -1;
+	data = NULL;
+	size = 0;
+} // unmap
+
+// End of MappedFile.cpp
@@ -0,0 +1,73 @@
+/*
+ * MappedFile.h
+ *
+ * Description: Destination file mapped into memory (Linux only). The
+ *              final size is known before coding, so the file is
+ *              allocated at once and the data is written straight into
+ *              the mapping, without write calls or seeking back.
+ *
+ *
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+class MappedFile {
+private:
+	int fd;						// -1 if no file is mapped.
+	char *data;					// Start of the mapping.
+	unsigned long long size;	// Size of the file and the mapping.
+
+	// Desc: Set the size of the open file and map it.
+	// Post: Return false if it fails. The file stays open.
+	bool setSize(unsigned long long size);
+
+	// Copying is not allowed.
+	MappedFile(const MappedFile &);
+	MappedFile &operator = (const MappedFile &);
+
+public:
+
+	// Constructor and destructor
+	MappedFile();
+	~MappedFile();
+
+	// Desc: Return true if "fileName" is a regular file, or does not
+	//       exist yet (map() then creates one). Other files, e.g. FIFOs
+	//       or devices, cannot be resized and mapped, and are written as
+	//       streams.
+	static bool isRegularFile(const char *fileName);
+
+	// Desc: Open "fileName" (created if needed), make it exactly "size"
+	//       bytes long with its blocks allocated up front, and map it.
+	//       The first bytes already in the file are kept.
+	// Post: Return false if the file cannot be mapped (e.g. not on Linux).
+	//       Nothing is mapped then, the file has its old size again, and
+	//       the caller writes the file normally.
+	bool map(const char *fileName, unsigned long long size);
+
+	// Desc: Change the size of the mapped file, e.g. to add more data.
+	//       The data in the first "size" bytes is kept, but the address
+	//       of the mapping may change.
+	//  Pre: isMapped() is true.
+	// Post: Return false if the file cannot be resized.
+	bool resize(unsigned long long size);
+
+	// Desc: Return true if a file is mapped.
+	bool isMapped() const;
+
+	// Desc: Return the mapped data (NULL if the file is empty).
+	//  Pre: isMapped() is true.
+	char *getData() const;
+
+	// Desc: Return the size of the mapped file.
+	unsigned long long getSize() const;
+
+	// Desc: Unmap and close the file.
+	void unmap();
+
+}; // MappedFile
+
+#endif
+
+// End of MappedFile.h
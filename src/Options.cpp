@@ -0,0 +1,37 @@
+/*
+ * Options.cpp
+ *
+ * Description: Options that control the compression / decompression.
+ *              Filled in by main() from the command-line arguments.
+ *
+ *
+ */
+
+#include <cstddef>
+#include "Options.h"
+#include "Filter.h"
+#include "HeaderFormat.h"
+
+// Desc: Default constructor
+//       Every option is set to its default value.
+Options::Options() {
+	tableFile = NULL;
+	pipeline = false;
+	numOfThreads = 1;
+	cache = NULL;
+	batch = false;
+	stats = NULL;
+	samplePercent = 100;
+	append = false;
+	lzWindow = 0;
+	bwt = false;
+	runs = false;
+	symbolBits = 8;
+	frames = false;
+	frameSize = 0;
+	coder = HUFFMAN_CODER;
+	filter = NO_FILTER;
+	filterStride = 0;
+} // Default constructor
+
+// End of Options.cpp
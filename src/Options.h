@@ -0,0 +1,91 @@
+/*
+ * Options.h
+ *
+ * Description: Options that control the compression / decompression.
+ *              Filled in by main() from the command-line arguments.
+ *
+ *
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+class CodeTableCache;
+class Stats;
+
+// Largest number of threads (-j). The coders keep a block of up to a few
+// MB per thread, so the memory they use grows with it.
+const unsigned MAX_THREADS = 256;
+
+class Options {
+public:
+	// Path of a pre-trained static table (see "StaticTable.cpp").
+	// NULL if the frequency table is stored in the file header.
+	const char *tableFile;
+
+	// Overlap reading, coding and writing using background
+	// I/O threads (see "Pipeline.cpp").
+	bool pipeline;
+
+	// Number of threads used for coding (see "ParallelEncode.cpp").
+	unsigned numOfThreads;
+
+	// Cache of ready-to-use code tables shared by several files
+	// (see "CodeTableCache.h"). NULL if every file builds its own.
+	CodeTableCache *cache;
+
+	// Treat the source as a list of files and the destination
+	// as a directory.
+	bool batch;
+
+	// Per-stage timing and counters, filled in by compress() and
+	// decompress() (see "Stats.h"). NULL if not collected.
+	Stats *stats;
+
+	// Percentage of the source file counted by --estimate.
+	// 100 gives the exact compressed size.
+	unsigned samplePercent;
+
+	// Add the compressed data as a new member at the end of an
+	// existing compressed file (see "Trailer.h").
+	bool append;
+
+	// Window of the LZ77 method in bytes, a power of two (see "Lz77.h").
+	// 0 if the characters are Huffman coded as they are.
+	unsigned lzWindow;
+
+	// Code the source file with the BWT method (see "Bwt.h").
+	bool bwt;
+
+	// Code runs of a repeated character as such (see "HuffmanBlocks.h").
+	bool runs;
+
+	// Size of the Huffman coded symbols in bits: 8 (bytes) or 16 (the
+	// 16-bit little-endian values of the source, see "HuffmanBlocks.h").
+	unsigned symbolBits;
+
+	// Code each byte position within frames of "frameSize" bytes with
+	// its own tree (see "HuffmanBlocks.h"). A frame size of 0 is
+	// detected from the start of the file.
+	bool frames;
+	unsigned frameSize;
+
+	// Entropy coder of the blocks (see "HeaderFormat.h"). AUTO_CODER
+	// chooses the one that spends the fewest bits on each block.
+	char coder;
+
+	// Filter of the source file, and the size of its values in bytes
+	// (see "Filter.h"). AUTO_FILTER, or a stride of 0, is detected from
+	// the start of the file.
+	char filter;
+	unsigned filterStride;
+
+	// Desc: Default constructor
+	//       Every option is set to its default value.
+	Options();
+
+}; // Options
+
+#endif
+
+// End of Options.h
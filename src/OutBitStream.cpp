@@ -15,6 +15,8 @@ using namespace std;
 // Desc: Default constructor
 OutBitStream::OutBitStream() {
 	totalNumOfBytes = 0;
+	numOfWrites = 0;
+	base = 0;
 	bitMask = 0x80;			// "1000 0000"
 	buffer = new char(0);	// Initialize to 0
 } // Default constructor
@@ -22,6 +24,8 @@ OutBitStream::OutBitStream() {
 // Desc: Non-default constructor
 OutBitStream::OutBitStream(const char *fileName) {
 	totalNumOfBytes = 0;
+	numOfWrites = 0;
+	base = 0;
 	bitMask = 0x80;			// "1000 0000"
 	buffer = new char(0);	// Initialize to 0
 	openFile(fileName);
@@ -38,6 +42,8 @@ OutBitStream::~OutBitStream() {
 //       Otherwise, return false.
 bool OutBitStream::openFile(const char *fileName) {
 	this -> totalNumOfBytes = 0;
+	this -> numOfWrites = 0;
+	this -> base = 0;
 	if (fout.is_open() == true)
 		fout.close();
 	(this -> fout).open(fileName, ios::out | ios::binary);
@@ -48,6 +54,24 @@ bool OutBitStream::openFile(const char *fileName) {
 	}
 } // openFile
 
+// Desc: Open an existing file and keep its first "offset" bytes.
+//       The data is written from "offset" on, and the positions
+//       given to writeByteAt() and writeValueAt() are relative to it.
+// Post: If it is opened successfully, return true.
+//       Otherwise, return false.
+bool OutBitStream::openFileAt(const char *fileName, unsigned long long offset) {
+	this -> totalNumOfBytes = 0;
+	this -> numOfWrites = 0;
+	this -> base = offset;
+	if (fout.is_open() == true)
+		fout.close();
+	(this -> fout).open(fileName, ios::in | ios::out | ios::binary);
+	if (!fout.is_open())
+		return false;
+	fout.seekp(offset, ios::beg);
+	return true;
+} // openFileAt
+
 
 // Desc: Write the remaining bits (if any) in the buffer to file
 //       and close the destination file.
@@ -56,11 +80,17 @@ void OutBitStream::closeFile() {
 	fout.close();
 } // closeFile
 
+// Desc: Return true if the destination file is open.
+bool OutBitStream::isOpen() const {
+	return fout.is_open();
+} // isOpen
+
 // Desc: Write the remaining bits (if any) in the buffer to file.
 void OutBitStream::sendEOF() {
 	// Write the remaining bits (if any) to file.
 	if (bitMask != 0x80) {
 		fout.write(buffer, 1);
+		numOfWrites++;
 		totalNumOfBytes++;
 							// Reset the buffer and bitMask.
 		bitMask = 0x80;		// "1000 0000"
@@ -68,6 +98,12 @@ void OutBitStream::sendEOF() {
 	}
 } // sendEOF
 
+// Desc: Pass the data written so far on to the file, so that
+//       the file can be accessed by other means.
+void OutBitStream::flush() {
+	fout.flush();
+} // flush
+
 
 // Desc: Find the code for the given character and 
 //       write the code to the buffer.
@@ -85,6 +121,7 @@ void OutBitStream::loadNextByte(const char &c, unsigned *codeTable, unsigned *co
 
 		if (bitMask == 0x0) {	// Buffer is full.
 			fout.write(buffer, 1);
+			numOfWrites++;
 			totalNumOfBytes++;
 								// Reset the buffer and bitMask.
 			bitMask = 0x80;		// "1000 0000"
@@ -96,30 +133,51 @@ void OutBitStream::loadNextByte(const char &c, unsigned *codeTable, unsigned *co
 // Desc: Write one byte to the file.
 void OutBitStream::writeByte(const char &data) {
 	fout.write(&data, 1);
+	numOfWrites++;
 } // writeByte
 
+// Desc: Write "size" bytes of already encoded data to the file.
+//  Pre: There are no remaining bits in the buffer.
+void OutBitStream::writeBlock(const char *data, const unsigned size) {
+	fout.write(data, size);
+	numOfWrites++;
+	totalNumOfBytes += size;
+} // writeBlock
+
 // Desc: Write one byte to the file at the given position.
+// Post: The file pointer is left where it was.
 void OutBitStream::writeByteAt(const unsigned offset, const char &data) {
-	fout.seekp(offset, ios::beg);
+	streampos current = fout.tellp();
+	fout.seekp(base + offset, ios::beg);
 	fout.write(&data, 1);
-	fout.seekp(0, ios::end);
+	numOfWrites++;
+	fout.seekp(current);
 } // writeByteAt
 
 // Desc: Convert the value to a "valueSize" bytes data chunk
 //       and write it to the file.
 void OutBitStream::writeValue(unsigned value, const unsigned valueSize) {
 	fout.write((char *)&value, valueSize);
+	numOfWrites++;
 } // writeValue
 
 // Desc: Convert the value to a "valueSize" bytes data chunk
 //       and write it to the file at the given position.
-// Post: The file pointer is pointing to the end of the file.
-void OutBitStream::writeValueAt(const unsigned offset, unsigned value, const unsigned valueSize) {
-	fout.seekp(offset, ios::beg);
+//  Pre: valueSize <= 8.
+// Post: The file pointer is left where it was.
+void OutBitStream::writeValueAt(const unsigned offset, unsigned long long value, const unsigned valueSize) {
+	streampos current = fout.tellp();
+	fout.seekp(base + offset, ios::beg);
 	fout.write((char *)&value, valueSize);
-	fout.seekp(0, ios::end);
+	numOfWrites++;
+	fout.seekp(current);
 } // writeValueAt
 
+// Desc: Returns the number of write calls made on the destination file.
+unsigned OutBitStream::getNumOfWrites() const {
+	return numOfWrites;
+} // getNumOfWrites
+
 // Desc: Returns the number of bytes that have been written to the destination file.
 unsigned OutBitStream::getTotalNumOfBytes() const {
 	return totalNumOfBytes;
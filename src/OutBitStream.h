@@ -20,6 +20,8 @@ private:
 	char *buffer;				// Used for storing the data temporarily.
 	short bitMask;				// bitMask
 	unsigned totalNumOfBytes;	// Number of bytes processed.
+	unsigned numOfWrites;		// Number of write calls on "fout".
+	unsigned long long base;	// Offset where the written data starts.
 public:
 
 	// Constructors and Destructor
@@ -32,13 +34,27 @@ public:
 	//       Otherwise, return false.
 	bool openFile(const char *fileName);
 
+	// Desc: Open an existing file and keep its first "offset" bytes.
+	//       The data is written from "offset" on, and the positions
+	//       given to writeByteAt() and writeValueAt() are relative to it.
+	// Post: If it is opened successfully, return true.
+	//       Otherwise, return false.
+	bool openFileAt(const char *fileName, unsigned long long offset);
+
 	// Desc: Write the remaining bits (if any) in the buffer to file
 	//       and close the destination file.
 	void closeFile();
 
+	// Desc: Return true if the destination file is open.
+	bool isOpen() const;
+
 	// Desc: Write the remaining bits (if any) in the buffer to file.
 	void sendEOF();
 
+	// Desc: Pass the data written so far on to the file, so that
+	//       the file can be accessed by other means.
+	void flush();
+
 	// Desc: Find the code for the given character and 
 	//       write the code to the buffer.
 	// Post: If buffer is full, its data will be written to the
@@ -48,7 +64,12 @@ public:
 	// Desc: Write one byte to the file.
 	void writeByte(const char &data);
 
+	// Desc: Write "size" bytes of already encoded data to the file.
+	//  Pre: There are no remaining bits in the buffer.
+	void writeBlock(const char *data, const unsigned size);
+
 	// Desc: Write one byte to the file at the given position.
+	// Post: The file pointer is left where it was.
 	void writeByteAt(const unsigned offset, const char &data);
 
 	// Desc: Convert the value to a "valueSize" bytes data chunk
@@ -57,8 +78,12 @@ public:
 
 	// Desc: Convert the value to a "valueSize" bytes data chunk
 	//       and write it to the file at the given position.
-	// Post: The file pointer is pointing to the end of the file.
-	void writeValueAt(const unsigned offset, unsigned value, const unsigned valueSize);
+	//  Pre: valueSize <= 8.
+	// Post: The file pointer is left where it was.
+	void writeValueAt(const unsigned offset, unsigned long long value, const unsigned valueSize);
+
+	// Desc: Returns the number of write calls made on the destination file.
+	unsigned getNumOfWrites() const;
 
 	// Desc: Returns the number of bytes that have been written to the destination file.
 	unsigned getTotalNumOfBytes() const;
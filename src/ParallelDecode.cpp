@@ -0,0 +1,274 @@
+/*
+ * ParallelDecode.cpp
+ *
+ * Description: Multi-threaded decoding of a single Huffman bitstream.
+ *              The file body has no index, so the threads start decoding
+ *              at arbitrary byte boundaries (speculatively). Huffman codes
+ *              self-synchronize quickly: soon after its start, a thread is
+ *              usually at the same code boundaries as a decoder that has
+ *              read the stream from the beginning.
+ *
+ *              After all threads finish, the chunks are stitched in order.
+ *              The true end of the previous chunk is looked up among the
+ *              first code boundaries of the next chunk. If it is not there,
+ *              the next chunk is decoded serially from the true boundary
+ *              until it reaches one of them, or to its end if it never does.
+ *              Therefore the output is always identical to serial decoding.
+ *
+ *
+ */
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "DecodeTable.h"
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "Trace.h"
+
+using namespace std;
+
+// Size of the compressed data decoded by one thread, in bytes.
+static const unsigned CHUNK_SIZE = 256 * 1024;
+
+// Number of code boundaries recorded at the beginning of each chunk.
+static const unsigned SYNC_WINDOW = 1024;
+
+// Bits kept after the last chunk of a segment, so that a code that starts
+// before the end of the chunk can always be completed.
+static const unsigned MARGIN_BITS = 64;
+
+// Desc: The result of decoding one chunk of a segment.
+//       Bit positions are counted from the beginning of the segment.
+class DecodedChunk {
+public:
+	vector<char> output;					// Decoded characters.
+	vector<unsigned long long> boundaries;	// Start of the first decoded codes.
+	unsigned long long endBit;				// End of the last decoded code.
+	bool isCorrupted;
+}; // DecodedChunk
+
+// Desc: Prepare to decode from an arbitrary bit position of "base".
+static void seekBit(const char *base, unsigned long long bitPos, const char *&src, DecodeState &state) {
+	src = base + bitPos / 8;
+	state = DecodeState();
+	if (bitPos % 8 != 0) {
+		state.bits = (unsigned char)(*src++);
+		state.numOfBits = 8 - bitPos % 8;
+	}
+} // seekBit
+
+// Desc: Return the current bit position of the decoder.
+static unsigned long long tellBit(const char *base, const char *src, const DecodeState &state) {
+	return (unsigned long long)(src - base) * 8 - state.numOfBits;
+} // tellBit
+
+// Desc: Decode the codes that start in [startBit, endBit) of "base", at most
+//       "maxChars" of them. The first SYNC_WINDOW boundaries are recorded.
+//  Pre: The data in [base, baseEnd) is available.
+static void decodeChunk(const DecodeTable *decodeTable, const char *base, const char *baseEnd,
+	unsigned long long startBit, unsigned long long endBit, unsigned maxChars, DecodedChunk *chunk) {
+	TRACE_SCOPE("decode chunk");
+
+	const char *src;
+	DecodeState state;
+	seekBit(base, startBit, src, state);
+
+	chunk -> output.clear();
+	chunk -> boundaries.clear();
+	chunk -> isCorrupted = false;
+
+	const char *chunkEnd = base + endBit / 8;
+	unsigned long long pos = startBit;
+	char character;
+
+	while (pos < endBit && chunk -> output.size() < maxChars) {
+		if (chunk -> boundaries.size() < SYNC_WINDOW) {
+			// One code at a time, recording where each code starts.
+			chunk -> boundaries.push_back(pos);
+			if (decodeTable -> decode(src, baseEnd, &character, 1, state) == 0) {
+				chunk -> boundaries.pop_back();
+				break;	// No more input or an invalid code.
+			}
+			chunk -> output.push_back(character);
+		} else if (src < chunkEnd) {
+			// Many codes at a time, up to the end of the chunk.
+			unsigned size = chunk -> output.size();
+			unsigned room = maxChars - size;
+			unsigned estimate = (chunkEnd - src) * 8 + 64;
+			chunk -> output.resize(size + (room < estimate ? room : estimate));
+			unsigned count = decodeTable -> decode(src, chunkEnd, &chunk -> output[size], chunk -> output.size() - size, state);
+			chunk -> output.resize(size + count);
+			if (count == 0 && state.isCorrupted)
+				break;
+		} else {
+			// The last code may end after the end of the chunk.
+			if (decodeTable -> decode(src, baseEnd, &character, 1, state) == 0)
+				break;
+			chunk -> output.push_back(character);
+		}
+		pos = tellBit(base, src, state);
+	}
+
+	chunk -> endBit = pos;
+	chunk -> isCorrupted = state.isCorrupted;
+} // decodeChunk
+
+// Desc: Decode serially from the true boundary "startBit" until the decoder
+//       reaches one of the recorded boundaries of the speculative chunk.
+// Post: Returns true if synchronized. The characters decoded up to that
+//       point are in "prefix", and "index" is the matching boundary.
+static bool synchronize(const DecodeTable &decodeTable, const char *base, const char *baseEnd,
+	unsigned long long startBit, const DecodedChunk &chunk, vector<char> &prefix, unsigned &index) {
+	TRACE_SCOPE("synchronize");
+
+	prefix.clear();
+	if (chunk.boundaries.empty())
+		return false;
+
+	const char *src;
+	DecodeState state;
+	seekBit(base, startBit, src, state);
+	unsigned long long pos = startBit;
+	char character;
+
+	while (pos <= chunk.boundaries.back()) {
+		vector<unsigned long long>::const_iterator it = lower_bound(chunk.boundaries.begin(), chunk.boundaries.end(), pos);
+		if (*it == pos) {
+			index = it - chunk.boundaries.begin();
+			return true;
+		}
+		if (decodeTable.decode(src, baseEnd, &character, 1, state) == 0)
+			return false;
+		prefix.push_back(character);
+		pos = tellBit(base, src, state);
+	}
+	return false;
+} // synchronize
+
+// Desc: Write "size" decoded characters to "out", or to "dst" (after the
+//       "written" characters already there) if it is not NULL.
+static void writeDecoded(OutBitStream *out, char *dst, unsigned &written, const char *data, unsigned size) {
+	if (size == 0)
+		return;		// "data" may be NULL then, e.g. an empty prefix.
+	if (dst != NULL)
+		memcpy(dst + written, data, size);
+	else
+		out -> writeBlock(data, size);
+	written += size;
+} // writeDecoded
+
+// Desc: Decode "originalFileSize" characters from "in" with "numOfThreads"
+//       threads and write them to "out", or to "dst" if it is not NULL.
+// Post: Return false if the compressed data is corrupted or ends too early.
+static bool decodeSegments(InBitStream &in, OutBitStream *out, char *dst, const DecodeTable &decodeTable, unsigned originalFileSize, unsigned numOfThreads) {
+	// At most MAX_THREADS (see "Options.h") chunks, well within 4 GB.
+	const unsigned long long segmentSize = (unsigned long long)CHUNK_SIZE * numOfThreads;
+	char *segment = new char[segmentSize];
+	unsigned size = 0;				// Number of bytes in the segment.
+	unsigned long long trueBit = 0;	// True code boundary, where decoding continues.
+	bool isEnd = false;
+
+	vector<DecodedChunk> chunks(numOfThreads);
+	vector<unsigned long long> starts(numOfThreads + 1);
+	vector<thread> workers;
+	DecodedChunk serial;
+	vector<char> prefix;
+
+	unsigned processedChar = 0;
+	bool isCorrupted = false;
+
+	while (processedChar < originalFileSize && isCorrupted == false) {
+
+		// Keep the bytes after the true boundary and fill the segment.
+		unsigned keep = trueBit / 8;
+		memmove(segment, segment + keep, size - keep);
+		size -= keep;
+		trueBit %= 8;
+		while (size < segmentSize && isEnd == false) {
+			unsigned numOfBytes = in.readBlock(segment + size, segmentSize - size);
+			size += numOfBytes;
+			isEnd = (numOfBytes == 0);
+		}
+
+		// Split the segment into byte-aligned chunks.
+		unsigned long long limit = (unsigned long long)size * 8;
+		if (isEnd == false)
+			limit = limit > MARGIN_BITS ? limit - MARGIN_BITS : 0;
+		if (limit <= trueBit)
+			break;	// Not enough data.
+		starts[0] = trueBit;
+		for (unsigned i = 1; i < numOfThreads; i++)
+			starts[i] = (trueBit + (limit - trueBit) * i / numOfThreads) / 8 * 8;
+		starts[numOfThreads] = limit;
+
+		// Decode all chunks speculatively.
+		unsigned remaining = originalFileSize - processedChar;
+		workers.clear();
+		for (unsigned i = 0; i < numOfThreads; i++) {
+			workers.push_back(thread(
+				decodeChunk, &decodeTable, segment, segment + size,
+				starts[i], starts[i + 1], remaining, &chunks[i]
+			));
+		}
+		for (unsigned i = 0; i < numOfThreads; i++)
+			workers[i].join();
+
+		// Stitch the chunks together along the true code boundaries.
+		unsigned long long lastBit = trueBit;
+		for (unsigned i = 0; i < numOfThreads && processedChar < originalFileSize; i++) {
+			if (trueBit >= starts[i + 1])
+				continue;	// Covered by the previous chunk.
+
+			DecodedChunk *chunk = &chunks[i];
+			unsigned index = 0;
+			prefix.clear();
+			if (trueBit != starts[i] && synchronize(decodeTable, segment, segment + size, trueBit, *chunk, prefix, index) == false) {
+				// Not synchronized, decode the chunk serially.
+				prefix.clear();
+				index = 0;
+				decodeChunk(&decodeTable, segment, segment + size, trueBit, starts[i + 1], originalFileSize - processedChar, &serial);
+				chunk = &serial;
+			}
+			isCorrupted = chunk -> isCorrupted;
+
+			// Write the characters (at most the remaining ones).
+			unsigned count = prefix.size() + chunk -> output.size() - index;
+			remaining = originalFileSize - processedChar;
+			unsigned prefixCount = prefix.size() < remaining ? prefix.size() : remaining;
+			writeDecoded(out, dst, processedChar, prefix.data(), prefixCount);
+			remaining -= prefixCount;
+			unsigned chunkCount = chunk -> output.size() - index;
+			chunkCount = chunkCount < remaining ? chunkCount : remaining;
+			writeDecoded(out, dst, processedChar, chunk -> output.data() + index, chunkCount);
+
+			trueBit = chunk -> endBit;
+			if (count == 0 || isCorrupted)
+				break;	// No progress, or an invalid code.
+		}
+
+		if (isEnd && trueBit == lastBit)
+			break;	// The end of data is reached.
+	}
+
+	delete [] segment;
+	return processedChar >= originalFileSize;
+} // decodeSegments
+
+// Desc: Decode "originalFileSize" characters from "in" with "numOfThreads"
+//       threads and write them to "out".
+// Post: Return false if the compressed data is corrupted or ends too early.
+bool decodeParallel(InBitStream &in, OutBitStream &out, const DecodeTable &decodeTable, unsigned originalFileSize, unsigned numOfThreads) {
+	return decodeSegments(in, &out, NULL, decodeTable, originalFileSize, numOfThreads);
+} // decodeParallel
+
+// Desc: Decode "originalFileSize" characters from "in" with "numOfThreads"
+//       threads straight into "dst", e.g. a mapped destination file.
+//  Pre: "dst" has room for "originalFileSize" characters.
+// Post: Return false if the compressed data is corrupted or ends too early.
+bool decodeParallelInPlace(InBitStream &in, char *dst, const DecodeTable &decodeTable, unsigned originalFileSize, unsigned numOfThreads) {
+	return decodeSegments(in, NULL, dst, decodeTable, originalFileSize, numOfThreads);
+} // decodeParallelInPlace
+
+// End of ParallelDecode.cpp
@@ -0,0 +1,168 @@
+/*
+ * ParallelEncode.cpp
+ *
+ * Description: Multi-threaded encoding into one bitstream.
+ *              The source is read in segments, and each segment is split
+ *              into one chunk per thread. Since the code lengths are known,
+ *              the size of each encoded chunk (in bits) follows from its
+ *              histogram. A prefix sum of these sizes gives the exact bit
+ *              offset of every chunk, so all threads encode directly into
+ *              one shared output buffer. The result is identical to the
+ *              output of the serial encoder.
+ *
+ *
+ */
+
+#include <thread>
+#include <vector>
+#include "BitBuffer.h"
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "Trace.h"
+
+using namespace std;
+
+// Size of the chunk encoded by one thread, in bytes.
+static const unsigned CHUNK_SIZE = 1024 * 1024;
+
+// Desc: Count the number of bits needed to encode a chunk.
+static void countBits(const char *data, unsigned size, const unsigned *codeLengthTable, unsigned long long *numOfBits) {
+	TRACE_SCOPE("count bits");
+	unsigned histogram[256] = {0};
+	for (unsigned i = 0; i < size; i++)
+		histogram[data[i] + 128]++;
+
+	unsigned long long sum = 0;
+	for (int i = 0; i < 256; i++)
+		sum += (unsigned long long)histogram[i] * codeLengthTable[i];
+	*numOfBits = sum;
+} // countBits
+
+// Desc: Encode a chunk into "dst", starting "startBit" bits from its beginning.
+//       The first "startBit % 8" bits are filled with "leadingBits".
+// Post: Only complete bytes are written to "dst". The remaining bits are
+//       returned in "tailByte", aligned to the most significant bit.
+static void encodeChunk(const char *data, unsigned size, const unsigned *codeTable, const unsigned *codeLengthTable,
+	const PairCodeTable *pairs, char *dst, unsigned long long startBit, unsigned leadingBits, char *tailByte) {
+	TRACE_SCOPE("encode chunk");
+
+	BitBuffer buffer;
+	buffer.setDestination(dst + startBit / 8);
+	buffer.writeCode(leadingBits, startBit % 8);
+	buffer.encode(data, size, codeTable, codeLengthTable, pairs);
+	*tailByte = buffer.getPendingByte();
+} // encodeChunk
+
+// Desc: Encode the source file with "numOfThreads" threads. The encoded
+//       data is written to "out", or straight into the "dstSize" bytes of
+//       "dst" if it is not NULL.
+// Post: The last byte is padded with 0's. Return false if the encoded
+//       data does not fill "dst" exactly.
+static bool encodeSegments(InBitStream &in, OutBitStream *out, char *dst, unsigned long long dstSize, 
+	unsigned *codeTable, unsigned *codeLengthTable, const PairCodeTable *pairs, unsigned numOfThreads) {
+	// At most MAX_THREADS (see "Options.h") chunks, well within 4 GB.
+	const unsigned long long segmentSize = (unsigned long long)CHUNK_SIZE * numOfThreads;
+	char *segment = new char[segmentSize];
+	char *encoded = (dst != NULL) ? dst : new char[4 * (unsigned long long)segmentSize + 1];
+
+	vector<unsigned long long> numOfBits(numOfThreads), offsets(numOfThreads + 1);
+	vector<unsigned> chunkSizes(numOfThreads);
+	vector<char> tails(numOfThreads);
+	vector<thread> workers;
+
+	// Bits left over from the previous segment, and the bit offset of
+	// the segment in "encoded" (always 0 when writing to "out").
+	unsigned carryBits = 0, carryCount = 0;
+	unsigned long long base = 0;
+	bool isFitting = true;
+
+	unsigned size;
+	while (isFitting && (size = in.readBlock(segment, segmentSize)) > 0) {
+
+		// Split the segment into chunks.
+		for (unsigned i = 0; i < numOfThreads; i++) {
+			unsigned begin = i * CHUNK_SIZE;
+			chunkSizes[i] = begin >= size ? 0 : (size - begin < CHUNK_SIZE ? size - begin : CHUNK_SIZE);
+		}
+
+		// Size of each encoded chunk.
+		workers.clear();
+		for (unsigned i = 0; i < numOfThreads; i++)
+			workers.push_back(thread(countBits, segment + i * CHUNK_SIZE, chunkSizes[i], codeLengthTable, &numOfBits[i]));
+		for (unsigned i = 0; i < numOfThreads; i++)
+			workers[i].join();
+
+		// Prefix sum: bit offset of each chunk.
+		offsets[0] = base + carryCount;
+		for (unsigned i = 0; i < numOfThreads; i++)
+			offsets[i + 1] = offsets[i] + numOfBits[i];
+		if (dst != NULL && (offsets[numOfThreads] + 7) / 8 > dstSize) {
+			isFitting = false;
+			break;
+		}
+
+		// Encode all chunks at their offsets.
+		workers.clear();
+		for (unsigned i = 0; i < numOfThreads; i++) {
+			workers.push_back(thread(
+				encodeChunk, segment + i * CHUNK_SIZE, chunkSizes[i], codeTable, codeLengthTable, pairs,
+				encoded, offsets[i], i == 0 ? carryBits : 0, &tails[i]
+			));
+		}
+		for (unsigned i = 0; i < numOfThreads; i++)
+			workers[i].join();
+
+		// Merge the bytes shared by two neighbouring chunks.
+		// If chunk i wrote no complete byte, its byte is still pending.
+		for (unsigned i = 1; i < numOfThreads; i++) {
+			if (offsets[i] % 8 == 0)
+				continue;
+			if (offsets[i + 1] / 8 > offsets[i] / 8)
+				encoded[offsets[i] / 8] |= tails[i - 1];
+			else
+				tails[i] |= tails[i - 1];
+		}
+
+		if (out != NULL)
+			out -> writeBlock(encoded, offsets[numOfThreads] / 8);
+		else
+			base = offsets[numOfThreads] / 8 * 8;
+		carryCount = offsets[numOfThreads] % 8;
+		carryBits = carryCount == 0 ? 0 : ((unsigned char)tails[numOfThreads - 1] >> (8 - carryCount));
+	}
+
+	// Write the remaining bits (if any).
+	if (isFitting && carryCount > 0) {
+		char last = (char)(carryBits << (8 - carryCount));
+		if (out != NULL)
+			out -> writeBlock(&last, 1);
+		else
+			encoded[base / 8] = last;
+	}
+
+	delete [] segment;
+	if (dst == NULL)
+		delete [] encoded;
+	return dst == NULL || (isFitting && (base + carryCount + 7) / 8 == dstSize);
+} // encodeSegments
+
+// Desc: Encode the source file with "numOfThreads" threads and write the
+//       compressed data to "out". "pairs" (if not NULL) encodes two
+//       characters per lookup.
+// Post: The last byte is padded with 0's.
+void encodeParallel(InBitStream &in, OutBitStream &out, unsigned *codeTable, unsigned *codeLengthTable, 
+	const PairCodeTable *pairs, unsigned numOfThreads) {
+	encodeSegments(in, &out, NULL, 0, codeTable, codeLengthTable, pairs, numOfThreads);
+} // encodeParallel
+
+// Desc: Encode the source file with "numOfThreads" threads straight into
+//       the "dstSize" bytes of "dst", e.g. a mapped destination file.
+// Post: The last byte is padded with 0's. Return false if the encoded
+//       data does not fill "dst" exactly, i.e. the source has changed
+//       since it was counted.
+bool encodeParallelInPlace(InBitStream &in, char *dst, unsigned long long dstSize, 
+	unsigned *codeTable, unsigned *codeLengthTable, const PairCodeTable *pairs, unsigned numOfThreads) {
+	return encodeSegments(in, NULL, dst, dstSize, codeTable, codeLengthTable, pairs, numOfThreads);
+} // encodeParallelInPlace
+
+// End of ParallelEncode.cpp
@@ -0,0 +1,84 @@
+/*
+ * PerfCounters.cpp
+ *
+ * Description: Hardware performance counters of the process, read
+ *              through perf_event_open (Linux only). The counters
+ *              include the threads created after they are opened, once
+ *              those threads have been joined.
+ *
+ *
+ */
+
+#include <cstring>
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+using namespace std;
+
+// Desc: Constructor
+//       The events are opened and start counting immediately.
+PerfCounters::PerfCounters() {
+	for (int i = 0; i < NUM_OF_EVENTS; i++)
+		fds[i] = -1;
+
+#ifdef __linux__
+	const unsigned long long configs[NUM_OF_EVENTS] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_BRANCH_MISSES,
+		PERF_COUNT_HW_CACHE_MISSES
+	};
+
+	for (int i = 0; i < NUM_OF_EVENTS; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.exclude_kernel = 1;	// Allowed with perf_event_paranoid <= 2.
+		attr.exclude_hv = 1;
+		attr.inherit = 1;			// Count the worker threads too.
+		fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+#endif
+} // Constructor
+
+// Desc: Destructor
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+	for (int i = 0; i < NUM_OF_EVENTS; i++)
+		if (fds[i] != -1)
+			close(fds[i]);
+#endif
+} // Destructor
+
+// Desc: Return true if "event" is being counted.
+bool PerfCounters::isAvailable(Event event) const {
+	return fds[event] != -1;
+} // isAvailable
+
+// Desc: Return true if at least one event is being counted.
+bool PerfCounters::isAvailable() const {
+	for (int i = 0; i < NUM_OF_EVENTS; i++)
+		if (fds[i] != -1)
+			return true;
+	return false;
+} // isAvailable
+
+// Desc: Read the current value of every event (0 if not available).
+void PerfCounters::read(unsigned long long values[NUM_OF_EVENTS]) const {
+	for (int i = 0; i < NUM_OF_EVENTS; i++) {
+		values[i] = 0;
+#ifdef __linux__
+		if (fds[i] != -1 && ::read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i]))
+			values[i] = 0;
+#endif
+	}
+} // read
+
+// End of PerfCounters.cpp
@@ -0,0 +1,46 @@
+/*
+ * PerfCounters.h
+ *
+ * Description: Hardware performance counters of the process, read
+ *              through perf_event_open (Linux only). The counters
+ *              include the threads created after they are opened, once
+ *              those threads have been joined.
+ *
+ *
+ */
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+class PerfCounters {
+public:
+	// Desc: The counted events.
+	enum Event { CYCLES, INSTRUCTIONS, BRANCH_MISSES, CACHE_MISSES, NUM_OF_EVENTS };
+
+private:
+	int fds[NUM_OF_EVENTS];		// -1 if the event is not available.
+
+	// Copying the counters is not allowed.
+	PerfCounters(const PerfCounters &);
+	PerfCounters &operator = (const PerfCounters &);
+
+public:
+	// Constructor and destructor
+	//       The events are opened and start counting immediately.
+	PerfCounters();
+	~PerfCounters();
+
+	// Desc: Return true if "event" is being counted.
+	bool isAvailable(Event event) const;
+
+	// Desc: Return true if at least one event is being counted.
+	bool isAvailable() const;
+
+	// Desc: Read the current value of every event (0 if not available).
+	void read(unsigned long long values[NUM_OF_EVENTS]) const;
+
+}; // PerfCounters
+
+#endif
+
+// End of PerfCounters.h
@@ -0,0 +1,211 @@
+/*
+ * Pipeline.cpp
+ *
+ * Description: Pipelined compression / decompression.
+ *              A reader thread, the coding stage (calling thread) and a
+ *              writer thread are connected by bounded ring buffers of
+ *              blocks, so that disk I/O overlaps with the coding.
+ *              At most PIPELINE_DEPTH blocks are allocated for each
+ *              direction, which keeps the memory usage bounded.
+ *
+ *
+ */
+
+#include <thread>
+#include <atomic>
+#include "BlockQueue.h"
+#include "BitBuffer.h"
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "FrequencyCounter.h"
+#include "DecodeTable.h"
+#include "Trace.h"
+
+using namespace std;
+
+// Size of one block, in bytes.
+static const unsigned PIPELINE_BLOCK_SIZE = 256 * 1024;
+
+// Number of blocks between two stages.
+static const int PIPELINE_DEPTH = 4;
+
+// Desc: A set of blocks circulating between two stages.
+//       Empty blocks wait in "empty", filled blocks wait in "full".
+class BlockRing {
+public:
+	Block *blocks[PIPELINE_DEPTH];
+	BlockQueue empty, full;
+
+	BlockRing() : empty(PIPELINE_DEPTH), full(PIPELINE_DEPTH) {
+		for (int i = 0; i < PIPELINE_DEPTH; i++) {
+			blocks[i] = new Block(PIPELINE_BLOCK_SIZE);
+			empty.push(blocks[i]);
+		}
+	}
+
+	~BlockRing() {
+		for (int i = 0; i < PIPELINE_DEPTH; i++)
+			delete blocks[i];
+	}
+}; // BlockRing
+
+// Desc: Reader stage. Fill empty blocks with data from the file.
+// Post: The "full" queue is closed at the end of file,
+//       or when "stop" is set by the consumer.
+static void readerStage(InBitStream *in, BlockRing *ring, atomic<bool> *stop) {
+	Block *block;
+	for (unsigned n = 0; !(*stop) && (block = ring -> empty.pop()) != NULL; n++) {
+		TRACE_SCOPE_ARG("read block", n);
+		block -> size = in -> readBlock(block -> data, block -> capacity);
+		if (block -> size == 0) {
+			ring -> empty.push(block);
+			break;
+		}
+		ring -> full.push(block);
+	}
+	ring -> full.close();
+} // readerStage
+
+// Desc: Writer stage. Write the filled blocks to the file.
+// Post: Returns when the "full" queue is closed and empty.
+static void writerStage(OutBitStream *out, BlockRing *ring) {
+	Block *block;
+	for (unsigned n = 0; (block = ring -> full.pop()) != NULL; n++) {
+		TRACE_SCOPE_ARG("write block", n);
+		out -> writeBlock(block -> data, block -> size);
+		ring -> empty.push(block);
+	}
+} // writerStage
+
+// Desc: Stop the reader stage and wait for it.
+//       Blocks that are still queued are recycled so that
+//       the reader never waits forever.
+static void stopReader(thread &reader, BlockRing &ring, atomic<bool> &stop) {
+	stop = true;
+	Block *block;
+	while ((block = ring.full.pop()) != NULL)
+		ring.empty.push(block);
+	reader.join();
+} // stopReader
+
+// Desc: Read data from the file and create the frequency table,
+//       while the next block is being read in the background.
+void countPipelined(InBitStream &in, FrequencyCounter &counter) {
+	BlockRing input;
+	atomic<bool> stop(false);
+	thread reader(readerStage, &in, &input, &stop);
+
+	Block *block;
+	for (unsigned n = 0; (block = input.full.pop()) != NULL; n++) {
+		TRACE_SCOPE_ARG("count block", n);
+		counter.countBlock(block -> data, block -> size);
+		input.empty.push(block);
+	}
+	reader.join();
+} // countPipelined
+
+// Desc: Encode the source file and write the compressed data to "out".
+//       Reading, encoding and writing run concurrently. "pairs" (if not
+//       NULL) encodes two characters per lookup.
+// Post: The last byte is padded with 0's.
+void encodePipelined(InBitStream &in, OutBitStream &out, unsigned *codeTable, unsigned *codeLengthTable, const PairCodeTable *pairs) {
+	BlockRing input, output;
+	atomic<bool> stop(false);
+	thread reader(readerStage, &in, &input, &stop);
+	thread writer(writerStage, &out, &output);
+
+	// Each character takes at most 4 bytes of code.
+	const unsigned maxCharsPerBlock = (PIPELINE_BLOCK_SIZE - 1) / 4;
+
+	BitBuffer buffer;
+	Block *outBlock = output.empty.pop();
+	buffer.setDestination(outBlock -> data);
+
+	Block *inBlock;
+	for (unsigned n = 0; (inBlock = input.full.pop()) != NULL; n++) {
+		TRACE_SCOPE_ARG("encode block", n);
+		unsigned pos = 0;
+		while (pos < inBlock -> size) {
+			unsigned room = (PIPELINE_BLOCK_SIZE - 1 - buffer.getLength()) / 4;
+			if (room == 0) {	// Output block is full.
+				outBlock -> size = buffer.getLength();
+				output.full.push(outBlock);
+				outBlock = output.empty.pop();
+				buffer.setDestination(outBlock -> data);
+				room = maxCharsPerBlock;
+			}
+			unsigned count = inBlock -> size - pos;
+			count = count < room ? count : room;
+			buffer.encode(inBlock -> data + pos, count, codeTable, codeLengthTable, pairs);
+			pos += count;
+		}
+		input.empty.push(inBlock);
+	}
+	reader.join();
+
+	// Write the remaining bits (if any).
+	buffer.flush();
+	outBlock -> size = buffer.getLength();
+	output.full.push(outBlock);
+	output.full.close();
+	writer.join();
+} // encodePipelined
+
+// Desc: Decode "originalFileSize" characters from "in" and write them to "out".
+//       Reading, decoding and writing run concurrently.
+// Post: Return false if the compressed data is corrupted or ends too early.
+bool decodePipelined(InBitStream &in, OutBitStream &out, const DecodeTable &decodeTable, unsigned originalFileSize) {
+	BlockRing input, output;
+	atomic<bool> stop(false);
+	thread reader(readerStage, &in, &input, &stop);
+	thread writer(writerStage, &out, &output);
+
+	DecodeState state;
+	unsigned processedChar = 0;
+	bool isEnd = false;
+
+	Block *outBlock = output.empty.pop();
+	outBlock -> size = 0;
+
+	while (processedChar < originalFileSize && state.isCorrupted == false) {
+		Block *inBlock = isEnd ? NULL : input.full.pop();
+		isEnd = (inBlock == NULL);
+		const char *pos = isEnd ? NULL : inBlock -> data;
+		const char *end = isEnd ? NULL : inBlock -> data + inBlock -> size;
+		TRACE_SCOPE("decode block");
+
+		// Decode the block. At the end of data, only the pending bits are left.
+		while (processedChar < originalFileSize) {
+			if (outBlock -> size == outBlock -> capacity) {	// Output block is full.
+				output.full.push(outBlock);
+				outBlock = output.empty.pop();
+				outBlock -> size = 0;
+			}
+			unsigned remaining = originalFileSize - processedChar;
+			unsigned room = outBlock -> capacity - outBlock -> size;
+			unsigned count = decodeTable.decode(
+				pos, end, outBlock -> data + outBlock -> size, 
+				remaining < room ? remaining : room, 
+				state
+			);
+			outBlock -> size += count;
+			processedChar += count;
+			if (count < room)
+				break;	// Need more input, corrupted or finished.
+		}
+
+		if (inBlock != NULL)
+			input.empty.push(inBlock);
+		else
+			break;
+	}
+	stopReader(reader, input, stop);
+
+	output.full.push(outBlock);
+	output.full.close();
+	writer.join();
+
+	return processedChar >= originalFileSize;
+} // decodePipelined
+
+// End of Pipeline.cpp
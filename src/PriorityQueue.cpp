@@ -11,8 +11,10 @@
 #include "PriorityQueue.h"
 
 // Desc: Constructor
-PriorityQueue::PriorityQueue() {
-	capacity = MAX_SIZE;
+//       "capacity" is the size of the alphabet, 256 characters
+//       by default.
+PriorityQueue::PriorityQueue(int capacity) {
+	this -> capacity = capacity;
 	arr = new NodePtr[capacity];
 	length = 0;
 } // Constructor
@@ -39,7 +39,9 @@ class PriorityQueue {
 	public:
 
 		// Desc: Default Constructor.
-		PriorityQueue();
+		//       "capacity" is the size of the alphabet, 256 characters
+		//       by default.
+		PriorityQueue(int capacity = MAX_SIZE);
 
 		// Desc: Copy Constructor.
 		PriorityQueue(const PriorityQueue &pq);
@@ -0,0 +1,117 @@
+/*
+ * StaticTable.cpp
+ *
+ * Description: Pre-trained static frequency tables.
+ *              A table is trained once from a sample corpus and saved
+ *              to a table file. Files compressed with it only store
+ *              the id of the table instead of the frequency table.
+ *
+ *              Table file format: [table id][bit flag][frequency table]
+ *
+ *
+ */
+
+#include <iostream>
+#include <cstring>
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "FrequencyCounter.h"
+#include "HeaderFormat.h"
+
+using namespace std;
+
+// Desc: Write / parse the bit flag and the frequency table.
+//       Implemented in "FileHeaderHandler.cpp".
+int writeFrequencyTable(OutBitStream &, FrequencyCounter &);
+int parseFrequencyTable(const char *, unsigned, FrequencyCounter &);
+
+// Largest weight kept in a trained table. Weights are scaled down
+// so that the table stays small and the codes stay short.
+static const unsigned MAX_TRAINED_WEIGHT = 65535;
+
+// Desc: Compute the id of a frequency table (FNV-1a hash of the weights).
+// Post: The id is never 0, which means "no static table".
+unsigned computeTableId(const unsigned *bitVector) {
+	unsigned hash = 2166136261u;
+	for (int i = 0; i < 256; i++) {
+		for (int j = 0; j < 4; j++) {
+			hash ^= (bitVector[i] >> (8 * j)) & 0xFF;
+			hash *= 16777619u;
+		}
+	}
+	return (hash == 0 ? 1 : hash);
+} // computeTableId
+
+// Desc: Train a static table from a sample corpus and save it to "tableFile".
+//       Every one of the 256 characters is given a non-zero weight, so that
+//       any input can be compressed with the table.
+// Post: Return 0 if success. Otherwise, return -1.
+int trainTable(const char *corpus, const char *tableFile) {
+
+	cout << "Training ..." << endl;
+
+	InBitStream in;
+	OutBitStream out;
+	FrequencyCounter sample;
+
+	if (in.openFile(corpus) == false) {
+		cout << "Error: Cannot open file \"" << corpus << "\"." << endl;
+		return -1;
+	}
+	sample.createTable(in);
+
+	// Scale the weights down to MAX_TRAINED_WEIGHT and smooth them,
+	// so that unseen characters still get a (long) code.
+	unsigned *sampleVector = sample.getBitVector();
+	unsigned maxWeight = sample.getMaxWeight();
+	unsigned bitVector[256];
+	for (int i = 0; i < 256; i++) {
+		unsigned long long weight = sampleVector[i];
+		if (maxWeight > MAX_TRAINED_WEIGHT)
+			weight = weight * MAX_TRAINED_WEIGHT / maxWeight;
+		bitVector[i] = (weight == 0 ? 1 : (unsigned)weight);
+	}
+
+	FrequencyCounter counter;
+	counter.restoreTable(bitVector);
+	unsigned tableId = computeTableId(bitVector);
+
+	if (out.openFile(tableFile) == false) {
+		cout << "Error: Cannot create destination file \"" << tableFile << "\"." << endl;
+		return -1;
+	}
+	out.writeValue(tableId, TABLE_ID_SIZE);
+	unsigned tableSize = TABLE_ID_SIZE + writeFrequencyTable(out, counter);
+	out.closeFile();
+
+	cout << corpus << " -> " << in.getFileSize() << " bytes" << endl;
+	cout << tableFile << " -> " << tableSize << " bytes, table id " << tableId << endl;
+	return 0;
+} // trainTable
+
+// Desc: Load a static table from "tableFile".
+// Post: Return true if success, with the table restored into "counter"
+//       and its id stored in "tableId". Otherwise, return false.
+bool loadStaticTable(const char *tableFile, FrequencyCounter &counter, unsigned &tableId) {
+	InBitStream in;
+	if (in.openFile(tableFile) == false) {
+		cout << "Error: Cannot open table file \"" << tableFile << "\"." << endl;
+		return false;
+	}
+
+	// A table file is never longer than a file header.
+	char data[TABLE_ID_SIZE + MAX_HEADER_SIZE];
+	unsigned size = in.readBlock(data, sizeof(data));
+	if (size > TABLE_ID_SIZE)
+		memcpy(&tableId, data, TABLE_ID_SIZE);
+	int tableSize = size > TABLE_ID_SIZE ? parseFrequencyTable(data + TABLE_ID_SIZE, size - TABLE_ID_SIZE, counter) : 0;
+
+	// Make sure the table has not been altered.
+	if (tableSize == 0 || tableId != computeTableId(counter.getBitVector()) || counter.getSize() != 256) {
+		cout << "Error: \"" << tableFile << "\" is not a valid table file." << endl;
+		return false;
+	}
+	return true;
+} // loadStaticTable
+
+// End of StaticTable.cpp
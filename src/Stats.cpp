@@ -0,0 +1,197 @@
+/*
+ * Stats.cpp
+ *
+ * Description: Per-stage timing and counters of one compression or
+ *              decompression, filled in when Options::stats is set
+ *              (--stats on the command line). With --profile, the
+ *              hardware counters of each stage are collected as well.
+ *              The heap allocations of each stage are counted in the
+ *              diagnostic build ("make ALLOC_STATS=1", see "AllocCounter.h").
+ *
+ *
+ */
+
+#include <cstdio>
+#include <sys/resource.h>
+#include "Stats.h"
+#include "AllocCounter.h"
+
+using namespace std;
+
+// Names of the stages, in the order of Stats::Stage.
+static const char *const STAGE_NAMES[Stats::NUM_OF_STAGES] = {
+	"count", "tree", "header", "encode", "patch", "decode"
+};
+
+// Desc: Default constructor
+//       All counters are set to zero.
+Stats::Stats() {
+	for (int i = 0; i < NUM_OF_STAGES; i++) {
+		seconds[i] = 0;
+		bytes[i] = 0;
+		hasRun[i] = false;
+	}
+	treeHeight = -1;
+	for (unsigned i = 0; i <= MAX_CODE_LENGTH; i++)
+		codeLengths[i] = 0;
+	originalSize = 0;
+	headerSize = 0;
+	bodySize = 0;
+	numOfWrites = 0;
+	perf = NULL;
+	for (int i = 0; i < NUM_OF_STAGES; i++)
+		for (int j = 0; j < PerfCounters::NUM_OF_EVENTS; j++)
+			events[i][j] = 0;
+	for (int i = 0; i < NUM_OF_STAGES; i++) {
+		numOfAllocations[i] = 0;
+		allocatedBytes[i] = 0;
+		peakRss[i] = 0;
+	}
+} // Default constructor
+
+// Desc: Read the current time and counters into "sample".
+void Stats::takeSample(Sample &sample) const {
+	if (perf != NULL) {
+		perf -> read(sample.events);
+	} else {
+		for (int i = 0; i < PerfCounters::NUM_OF_EVENTS; i++)
+			sample.events[i] = 0;
+	}
+	readAllocations(sample.numOfAllocations, sample.allocatedBytes);
+	sample.time = chrono::steady_clock::now();
+} // takeSample
+
+// Desc: Record what happened since "start", and the bytes processed by "stage".
+void Stats::record(Stage stage, const Sample &start, unsigned long long size) {
+	Sample end;
+	takeSample(end);
+
+	seconds[stage] += chrono::duration<double>(end.time - start.time).count();
+	bytes[stage] += size;
+	hasRun[stage] = true;
+
+	for (int i = 0; i < PerfCounters::NUM_OF_EVENTS; i++)
+		events[stage][i] += end.events[i] - start.events[i];
+	numOfAllocations[stage] += end.numOfAllocations - start.numOfAllocations;
+	allocatedBytes[stage] += end.allocatedBytes - start.allocatedBytes;
+
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		peakRss[stage] = usage.ru_maxrss;
+} // record
+
+// Desc: Record the height of the tree and the distribution of its code lengths.
+void Stats::recordTree(const HuffmanTree &tree) {
+	treeHeight = tree.getHeight(tree.getRoot());
+	for (unsigned i = 0; i <= MAX_CODE_LENGTH; i++)
+		codeLengths[i] = 0;
+
+	// Characters that are not in the tree have a code length of 0.
+	unsigned *codeLengthTable = tree.getCodeLengthTable();
+	for (int i = 0; i < 256; i++) {
+		unsigned length = codeLengthTable[i];
+		if (length != 0)
+			codeLengths[length < MAX_CODE_LENGTH ? length : MAX_CODE_LENGTH]++;
+	}
+} // recordTree
+
+// Desc: Print the report.
+void Stats::print(ostream &os) const {
+	char line[128];
+	double total = 0;
+
+	os << "Stage        Time (ms)        Bytes      MB/s" << endl;
+	for (int i = 0; i < NUM_OF_STAGES; i++) {
+		if (hasRun[i] == false)
+			continue;
+		double mbps = (seconds[i] > 0 && bytes[i] > 0) ? bytes[i] / seconds[i] / (1 << 20) : 0;
+		snprintf(line, sizeof(line), "%-8s %13.3f %12llu %9.2f", STAGE_NAMES[i], seconds[i] * 1000, bytes[i], mbps);
+		os << line << endl;
+		total += seconds[i];
+	}
+	snprintf(line, sizeof(line), "%-8s %13.3f", "total", total * 1000);
+	os << line << endl;
+
+	os << "Original size: " << originalSize << " bytes" << endl;
+	os << "Header size:   " << headerSize << " bytes" << endl;
+	os << "Body size:     " << bodySize << " bytes" << endl;
+	os << "Write calls:   " << numOfWrites << endl;
+
+	if (treeHeight >= 0) {
+		os << "Tree height:   " << treeHeight << endl;
+		os << "Code lengths:  ";
+		bool isFirst = true;
+		for (unsigned i = 1; i <= MAX_CODE_LENGTH; i++) {
+			if (codeLengths[i] == 0)
+				continue;
+			os << (isFirst ? "" : ", ") << i << (i == MAX_CODE_LENGTH ? "+" : "") << " bits x " << codeLengths[i];
+			isFirst = false;
+		}
+		os << endl;
+	}
+
+	printMemory(os);
+	if (perf != NULL)
+		printEvents(os);
+} // print
+
+// Desc: Print the peak RSS, and the allocations of each stage if counted.
+void Stats::printMemory(ostream &os) const {
+	char line[128];
+	long rss = 0;
+	for (int i = 0; i < NUM_OF_STAGES; i++)
+		rss = peakRss[i] > rss ? peakRss[i] : rss;
+	os << "Peak RSS:      " << rss << " KB" << endl;
+
+	if (isAllocationCounted() == false)
+		return;
+	os << "Stage      Allocations          Bytes  Peak RSS (KB)" << endl;
+	for (int i = 0; i < NUM_OF_STAGES; i++) {
+		if (hasRun[i] == false)
+			continue;
+		snprintf(line, sizeof(line), "%-8s %13llu %14llu %14ld", STAGE_NAMES[i], numOfAllocations[i], allocatedBytes[i], peakRss[i]);
+		os << line << endl;
+	}
+} // printMemory
+
+// Desc: Print the hardware counters of each stage.
+void Stats::printEvents(ostream &os) const {
+	if (perf -> isAvailable() == false) {
+		os << "Hardware counters are not available (perf_event_open failed)." << endl;
+		return;
+	}
+
+	char line[160], cell[32];
+	os << "Stage          Cycles   Instructions    IPC  Branch misses/B  Cache misses/B" << endl;
+	for (int i = 0; i < NUM_OF_STAGES; i++) {
+		if (hasRun[i] == false)
+			continue;
+		const unsigned long long *count = events[i];
+		int length = snprintf(line, sizeof(line), "%-8s", STAGE_NAMES[i]);
+
+		// One column per value, "n/a" when the event is not counted.
+		const bool available[] = {
+			perf -> isAvailable(PerfCounters::CYCLES),
+			perf -> isAvailable(PerfCounters::INSTRUCTIONS),
+			perf -> isAvailable(PerfCounters::CYCLES) && perf -> isAvailable(PerfCounters::INSTRUCTIONS) && count[PerfCounters::CYCLES] > 0,
+			perf -> isAvailable(PerfCounters::BRANCH_MISSES) && bytes[i] > 0,
+			perf -> isAvailable(PerfCounters::CACHE_MISSES) && bytes[i] > 0
+		};
+		const int widths[] = { 14, 15, 7, 17, 16 };
+		for (int j = 0; j < 5; j++) {
+			if (available[j] == false) {
+				snprintf(cell, sizeof(cell), "n/a");
+			} else if (j < 2) {
+				snprintf(cell, sizeof(cell), "%llu", count[j]);
+			} else if (j == 2) {
+				snprintf(cell, sizeof(cell), "%.2f", (double)count[PerfCounters::INSTRUCTIONS] / count[PerfCounters::CYCLES]);
+			} else {
+				snprintf(cell, sizeof(cell), "%.4f", (double)count[j == 3 ? PerfCounters::BRANCH_MISSES : PerfCounters::CACHE_MISSES] / bytes[i]);
+			}
+			length += snprintf(line + length, sizeof(line) - length, " %*s", widths[j], cell);
+		}
+		os << line << endl;
+	}
+} // printEvents
+
+// End of Stats.cpp
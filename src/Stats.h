@@ -0,0 +1,117 @@
+/*
+ * Stats.h
+ *
+ * Description: Per-stage timing and counters of one compression or
+ *              decompression, filled in when Options::stats is set
+ *              (--stats on the command line). With --profile, the
+ *              hardware counters of each stage are collected as well.
+ *              The heap allocations of each stage are counted in the
+ *              diagnostic build ("make ALLOC_STATS=1", see "AllocCounter.h").
+ *
+ *
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <ostream>
+#include "HuffmanTree.h"
+#include "PerfCounters.h"
+
+using namespace std;
+
+class Stats {
+public:
+	// Desc: Stages of compression and decompression, in the order they run.
+	//       COUNT:  build the frequency table (or load the static table).
+	//       TREE:   build the Huffman tree and the code tables.
+	//       HEADER: write or parse the file header.
+	//       ENCODE: encode the file body.
+	//       PATCH:  write the original file size into the header.
+	//       DECODE: decode the file body.
+	enum Stage { COUNT, TREE, HEADER, ENCODE, PATCH, DECODE, NUM_OF_STAGES };
+
+	// Code lengths above this value are counted together.
+	static const unsigned MAX_CODE_LENGTH = 32;
+
+	double seconds[NUM_OF_STAGES];				// Wall time of each stage.
+	unsigned long long bytes[NUM_OF_STAGES];	// Bytes processed by each stage.
+	bool hasRun[NUM_OF_STAGES];
+
+	int treeHeight;								// -1 if no tree was built.
+	unsigned codeLengths[MAX_CODE_LENGTH + 1];	// Number of characters per code length.
+
+	unsigned originalSize;
+	unsigned headerSize;
+	unsigned bodySize;
+	unsigned numOfWrites;						// Write calls on the output stream.
+
+	// Hardware counters of each stage. NULL if not profiling.
+	PerfCounters *perf;
+	unsigned long long events[NUM_OF_STAGES][PerfCounters::NUM_OF_EVENTS];
+
+	// Heap allocations of each stage (diagnostic build only).
+	unsigned long long numOfAllocations[NUM_OF_STAGES];
+	unsigned long long allocatedBytes[NUM_OF_STAGES];
+
+	// Peak resident set size of the process at the end of each stage, in KB.
+	long peakRss[NUM_OF_STAGES];
+
+	// Desc: The counters at the start of a stage.
+	struct Sample {
+		chrono::steady_clock::time_point time;
+		unsigned long long events[PerfCounters::NUM_OF_EVENTS];
+		unsigned long long numOfAllocations;
+		unsigned long long allocatedBytes;
+	}; // Sample
+
+	// Desc: Default constructor
+	//       All counters are set to zero.
+	Stats();
+
+	// Desc: Read the current time and counters into "sample".
+	void takeSample(Sample &sample) const;
+
+	// Desc: Record what happened since "start", and the bytes processed by "stage".
+	void record(Stage stage, const Sample &start, unsigned long long size);
+
+	// Desc: Record the height of the tree and the distribution of its code lengths.
+	void recordTree(const HuffmanTree &tree);
+
+	// Desc: Print the report.
+	void print(ostream &os) const;
+
+	// Desc: Print the peak RSS, and the allocations of each stage if counted.
+	void printMemory(ostream &os) const;
+
+	// Desc: Print the hardware counters of each stage.
+	//  Pre: "perf" is not NULL.
+	void printEvents(ostream &os) const;
+
+}; // Stats
+
+// Desc: Measures one stage, does nothing if "stats" is NULL.
+class StageTimer {
+private:
+	Stats *stats;
+	Stats::Stage stage;
+	Stats::Sample start;
+public:
+	// Constructor
+	//       The stage starts now.
+	StageTimer(Stats *stats, Stats::Stage stage) : stats(stats), stage(stage) {
+		if (stats != NULL)
+			stats -> takeSample(start);
+	}
+
+	// Desc: End the stage, which processed "size" bytes.
+	void stop(unsigned long long size) {
+		if (stats != NULL)
+			stats -> record(stage, start, size);
+	}
+}; // StageTimer
+
+#endif
+
+// End of Stats.h
@@ -0,0 +1,172 @@
+/*
+ * StreamDecoder.cpp
+ *
+ * Description: Resumable decoder working on caller-provided buffers.
+ *              The compressed data (header included) is passed in chunks
+ *              of any size, and the decoded data is written to an output
+ *              buffer supplied by the caller. The decoder itself only
+ *              keeps a copy of the header and a few pending bits, so the
+ *              memory usage does not depend on the size of the data.
+ *
+ *
+ */
+
+#include <cstring>
+#include "StreamDecoder.h"
+#include "FrequencyCounter.h"
+#include "HeaderFormat.h"
+
+using namespace std;
+
+// Desc: Parse the header of the compressed data.
+//       Implemented in "FileHeaderHandler.cpp".
+int parseFileHeader(const char *, unsigned, FrequencyCounter &, unsigned &, unsigned &);
+
+// Desc: Load a pre-trained static table.
+//       Implemented in "StaticTable.cpp".
+bool loadStaticTable(const char *, FrequencyCounter &, unsigned &);
+
+// Desc: Constructor
+//       "opt" gives the static table (if any) and the code table cache.
+StreamDecoder::StreamDecoder(const Options &opt) : opt(opt) {
+	header = new char[MAX_HEADER_SIZE];
+	headerLength = 0;
+	headerSize = 0;
+	tableId = 0;
+	originalFileSize = 0;
+	processedChar = 0;
+	status = NEED_INPUT;
+} // Constructor
+
+// Desc: Destructor
+StreamDecoder::~StreamDecoder() {
+	delete [] header;
+} // Destructor
+
+// Desc: Append header bytes and parse the header once it is complete.
+// Post: Returns the number of bytes taken from "src".
+unsigned StreamDecoder::readHeader(const char *src, unsigned size) {
+	// The methods of an extended header are decoded by decompress().
+	if (headerLength == 0 && size > 0 && (src[0] & ~FILTER_FLAG) == EXTENDED_FLAG) {
+		status = UNSUPPORTED_METHOD;
+		return 0;
+	}
+
+	unsigned count = MAX_HEADER_SIZE - headerLength;
+	count = count < size ? count : size;
+	memcpy(header + headerLength, src, count);
+	headerLength += count;
+
+	FrequencyCounter counter;
+	int totalHeaderSize = parseFileHeader(header, headerLength, counter, tableId, originalFileSize);
+	if (totalHeaderSize == 0) {
+		// A header never exceeds MAX_HEADER_SIZE bytes.
+		if (headerLength == MAX_HEADER_SIZE)
+			status = CORRUPTED;
+		return count;
+	}
+
+	// Only take the bytes that belong to the header.
+	count -= headerLength - totalHeaderSize;
+	headerLength = totalHeaderSize;
+
+	// The data was compressed with a static table.
+	if (tableId != 0) {
+		unsigned loadedId;
+		if (opt.tableFile == NULL || loadStaticTable(opt.tableFile, counter, loadedId) == false || loadedId != tableId) {
+			status = MISSING_TABLE;
+			return count;
+		}
+	}
+
+	if (opt.cache != NULL)
+		code = opt.cache -> get(counter);
+	else
+		code.reset(new HuffmanCode(counter));
+	headerSize = totalHeaderSize;
+	return count;
+} // readHeader
+
+// Desc: Decode the "srcSize" bytes of "src" into the "dstSize" bytes of "dst".
+// Post: "consumed" is the number of input bytes used and "produced" the
+//       number of characters written to "dst". Input that is not consumed
+//       must be passed again in the next call. Once FINISHED, bytes after
+//       the end of the compressed data are not counted as consumed.
+StreamDecoder::Status StreamDecoder::decode(const char *src, unsigned srcSize, unsigned &consumed, char *dst, unsigned dstSize, unsigned &produced) {
+	consumed = 0;
+	produced = 0;
+	if (status == FINISHED || status == CORRUPTED || status == MISSING_TABLE || status == UNSUPPORTED_METHOD)
+		return status;
+
+	if (headerSize == 0) {
+		consumed = readHeader(src, srcSize);
+		if (status != NEED_INPUT)
+			return status;
+		if (headerSize == 0)
+			return status = NEED_INPUT;
+	}
+
+	const char *body = src + consumed;
+	const char *pos = body;
+	unsigned remaining = originalFileSize - processedChar;
+	produced = code -> getDecodeTable().decode(
+		pos, src + srcSize, dst,
+		remaining < dstSize ? remaining : dstSize,
+		state
+	);
+	processedChar += produced;
+	consumed += pos - body;
+
+	if (state.isCorrupted)
+		return status = CORRUPTED;
+
+	if (processedChar == originalFileSize) {
+		// Give back the whole bytes that have been read ahead.
+		// The rest of the pending bits are padding.
+		unsigned readAhead = state.numOfBits / 8;
+		readAhead = readAhead < (unsigned)(pos - body) ? readAhead : (unsigned)(pos - body);
+		consumed -= readAhead;
+		state.numOfBits -= readAhead * 8;
+		return status = FINISHED;
+	}
+
+	return status = (produced == dstSize ? OUTPUT_FULL : NEED_INPUT);
+} // decode
+
+// Desc: Return true if the header has been parsed.
+bool StreamDecoder::hasHeader() const {
+	return headerSize != 0;
+} // hasHeader
+
+// Desc: Return the size of the header, including the original file size.
+//  Pre: hasHeader() is true.
+unsigned StreamDecoder::getHeaderSize() const {
+	return headerSize;
+} // getHeaderSize
+
+// Desc: Return the size of the original (decompressed) data.
+//  Pre: hasHeader() is true.
+unsigned StreamDecoder::getOriginalSize() const {
+	return originalFileSize;
+} // getOriginalSize
+
+// Desc: Return the size of the compressed data after the header.
+//       It follows from the frequency table, so it is only known
+//       when the table is stored in the header.
+//  Pre: hasHeader() is true and getTableId() is 0.
+unsigned long long StreamDecoder::getBodySize() const {
+	return code -> getEncodedSize();
+} // getBodySize
+
+// Desc: Return the id of the required static table, 0 if none.
+unsigned StreamDecoder::getTableId() const {
+	return tableId;
+} // getTableId
+
+// Desc: Return the code tables of the data.
+//  Pre: hasHeader() is true.
+shared_ptr<HuffmanCode> StreamDecoder::getCode() const {
+	return code;
+} // getCode
+
+// End of StreamDecoder.cpp
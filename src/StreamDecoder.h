@@ -0,0 +1,108 @@
+/*
+ * StreamDecoder.h
+ *
+ * Description: Resumable decoder working on caller-provided buffers.
+ *              The compressed data (header included) is passed in chunks
+ *              of any size, and the decoded data is written to an output
+ *              buffer supplied by the caller. The decoder itself only
+ *              keeps a copy of the header and a few pending bits, so the
+ *              memory usage does not depend on the size of the data.
+ *
+ *              Only members with a plain or static table header are
+ *              decoded. The methods of an extended header (LZ77, BWT,
+ *              blocks, see "HeaderFormat.h") keep whole blocks in memory
+ *              and are decoded from the file by decompress(); for them,
+ *              the decoder stops with UNSUPPORTED_METHOD.
+ *
+ *
+ */
+
+#ifndef STREAMDECODER_H
+#define STREAMDECODER_H
+
+#include <memory>
+#include "Options.h"
+#include "DecodeTable.h"
+#include "CodeTableCache.h"
+
+using namespace std;
+
+class StreamDecoder {
+public:
+	// Desc: Result of a call to decode().
+	//       NEED_INPUT:    all input is consumed, call again with more input.
+	//       OUTPUT_FULL:   the output buffer is full, call again with more room.
+	//       FINISHED:      all characters have been decoded.
+	//       CORRUPTED:     the data is not valid compressed data.
+	//       MISSING_TABLE: the required static table is not available.
+	//       UNSUPPORTED_METHOD: the data has an extended header, which
+	//                      this decoder does not handle. No input is
+	//                      consumed.
+	enum Status { NEED_INPUT, OUTPUT_FULL, FINISHED, CORRUPTED, MISSING_TABLE, UNSUPPORTED_METHOD };
+
+private:
+	Options opt;				// Static table and code table cache.
+
+	char *header;				// Header bytes received so far.
+	unsigned headerLength;
+	unsigned headerSize;		// Size of the complete header, 0 if unknown.
+
+	unsigned tableId;			// Id of the required static table, 0 if none.
+	unsigned originalFileSize;
+	unsigned processedChar;
+
+	shared_ptr<HuffmanCode> code;
+	DecodeState state;
+	Status status;				// Status of the last call.
+
+	// Desc: Append header bytes and parse the header once it is complete.
+	// Post: Returns the number of bytes taken from "src".
+	unsigned readHeader(const char *src, unsigned size);
+
+	// Copying a decoder is not allowed.
+	StreamDecoder(const StreamDecoder &);
+	StreamDecoder &operator = (const StreamDecoder &);
+
+public:
+
+	// Constructor and destructor
+	//       "opt" gives the static table (if any) and the code table cache.
+	StreamDecoder(const Options &opt);
+	~StreamDecoder();
+
+	// Desc: Decode the "srcSize" bytes of "src" into the "dstSize" bytes of "dst".
+	// Post: "consumed" is the number of input bytes used and "produced" the
+	//       number of characters written to "dst". Input that is not consumed
+	//       must be passed again in the next call. Once FINISHED, bytes after
+	//       the end of the compressed data are not counted as consumed.
+	Status decode(const char *src, unsigned srcSize, unsigned &consumed, char *dst, unsigned dstSize, unsigned &produced);
+
+	// Desc: Return true if the header has been parsed.
+	bool hasHeader() const;
+
+	// Desc: Return the size of the header, including the original file size.
+	//  Pre: hasHeader() is true.
+	unsigned getHeaderSize() const;
+
+	// Desc: Return the size of the original (decompressed) data.
+	//  Pre: hasHeader() is true.
+	unsigned getOriginalSize() const;
+
+	// Desc: Return the size of the compressed data after the header.
+	//       It follows from the frequency table, so it is only known
+	//       when the table is stored in the header.
+	//  Pre: hasHeader() is true and getTableId() is 0.
+	unsigned long long getBodySize() const;
+
+	// Desc: Return the id of the required static table, 0 if none.
+	unsigned getTableId() const;
+
+	// Desc: Return the code tables of the data.
+	//  Pre: hasHeader() is true.
+	shared_ptr<HuffmanCode> getCode() const;
+
+}; // StreamDecoder
+
+#endif
+
+// End of StreamDecoder.h
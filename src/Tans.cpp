@@ -0,0 +1,221 @@
+/*
+ * Tans.cpp
+ *
+ * Description: Table-based asymmetric numeral systems (tANS) coder.
+ *              The encoder keeps a state in [L, 2L), L = 2^TABLE_LOG.
+ *              To code a symbol of "n" slots, it writes the low bits of
+ *              the state until it is in [n, 2n), and moves to the state
+ *              that the decoder reaches from there. The decoder state is
+ *              the encoder state minus L, an index in the decode table.
+ *
+ *              Coded data: [bits of the symbols, the last symbol first]
+ *                          [final state][1 bit][0's to a complete byte]
+ *              The bits are packed from the least significant bit.
+ *
+ *
+ */
+
+#include <cstring>
+#include <cmath>
+#include "Tans.h"
+
+using namespace std;
+
+// Number of states.
+static const unsigned TABLE_SIZE = 1 << Tans::TABLE_LOG;
+
+// Desc: Return the position of the highest bit set in "value".
+//  Pre: value != 0.
+static unsigned highestBit(unsigned value) {
+	unsigned bit = 0;
+	while ((value >> (bit + 1)) != 0)
+		bit++;
+	return bit;
+} // highestBit
+
+// Desc: Scale "weights" to TABLE_SIZE slots, at least one for each
+//       symbol that occurs. The rounding is corrected one slot at a time
+//       on the symbols with the most slots, so that the encoder and the
+//       decoder get the same table from the same weights.
+void Tans::normalize(const unsigned *weights) {
+	unsigned long long total = 0;
+	for (unsigned i = 0; i < numOfSymbols; i++)
+		total += weights[i];
+
+	unsigned sum = 0;
+	for (unsigned i = 0; i < numOfSymbols; i++) {
+		slots[i] = 0;
+		if (weights[i] != 0) {
+			slots[i] = (unsigned)((weights[i] * (unsigned long long)TABLE_SIZE + total / 2) / total);
+			if (slots[i] == 0)
+				slots[i] = 1;
+		}
+		sum += slots[i];
+	}
+
+	while (sum != TABLE_SIZE) {
+		unsigned largest = 0;
+		for (unsigned i = 1; i < numOfSymbols; i++) {
+			if (slots[i] > slots[largest])
+				largest = i;
+		}
+		if (sum > TABLE_SIZE) {
+			slots[largest]--;
+			sum--;
+		} else {
+			slots[largest]++;
+			sum++;
+		}
+	}
+} // normalize
+
+// Desc: Constructor
+//       Build the tables from the weights of "numOfSymbols" symbols.
+Tans::Tans(const unsigned *weights, unsigned numOfSymbols) {
+	this -> numOfSymbols = numOfSymbols;
+	slots.resize(numOfSymbols);
+	firstSlot.resize(numOfSymbols);
+	encodeStates.resize(TABLE_SIZE);
+	entries.resize(TABLE_SIZE);
+	normalize(weights);
+
+	// Spread the slots of each symbol over the table. The step is odd,
+	// so every state is visited once.
+	vector<unsigned char> spread(TABLE_SIZE);
+	const unsigned step = (TABLE_SIZE >> 1) + (TABLE_SIZE >> 3) + 3;
+	unsigned position = 0;
+	unsigned first = 0;
+	for (unsigned i = 0; i < numOfSymbols; i++) {
+		firstSlot[i] = first;
+		first += slots[i];
+		for (unsigned j = 0; j < slots[i]; j++) {
+			spread[position] = i;
+			position = (position + step) & (TABLE_SIZE - 1);
+		}
+	}
+
+	// The k-th state of a symbol (in table order) is reached from the
+	// encoder states that are reduced to slots + k.
+	vector<unsigned> next(slots);
+	for (unsigned u = 0; u < TABLE_SIZE; u++) {
+		unsigned symbol = spread[u];
+		unsigned y = next[symbol]++;
+		unsigned numOfBits = TABLE_LOG - highestBit(y);
+		entries[u].baseState = (y << numOfBits) - TABLE_SIZE;
+		entries[u].symbol = symbol;
+		entries[u].numOfBits = numOfBits;
+		encodeStates[firstSlot[symbol] + y - slots[symbol]] = TABLE_SIZE + u;
+	}
+} // Constructor
+
+// Desc: Return the number of bits encode() writes for symbols counted
+//       in "weights", from the number of slots of each symbol.
+unsigned long long Tans::getCodedBits(const unsigned *weights) const {
+	double bits = TABLE_LOG + 1;
+	for (unsigned i = 0; i < numOfSymbols; i++) {
+		if (weights[i] != 0)
+			bits += weights[i] * (TABLE_LOG - log2((double)slots[i]));
+	}
+	return (unsigned long long)bits;
+} // getCodedBits
+
+// Desc: Code the "size" symbols of "src" into "dst".
+// Post: Returns the number of bytes written.
+unsigned Tans::encode(const unsigned char *src, unsigned size, char *dst) const {
+
+	// For each symbol: the number of bits written from the states at or
+	// above "threshold", one less below it.
+	vector<unsigned> maxBits(numOfSymbols), threshold(numOfSymbols);
+	for (unsigned i = 0; i < numOfSymbols; i++) {
+		if (slots[i] != 0) {
+			maxBits[i] = TABLE_LOG - highestBit(slots[i]);
+			threshold[i] = slots[i] << maxBits[i];
+		}
+	}
+
+	unsigned long long bits = 0;	// Pending bits, from the least significant.
+	unsigned numOfBits = 0;
+	unsigned length = 0;
+	unsigned state = TABLE_SIZE;
+	for (unsigned i = size; i-- > 0; ) {
+		unsigned symbol = src[i];
+		unsigned count = maxBits[symbol] - (state < threshold[symbol] ? 1 : 0);
+		bits |= (unsigned long long)(state & ((1u << count) - 1)) << numOfBits;
+		numOfBits += count;
+		state = encodeStates[firstSlot[symbol] + (state >> count) - slots[symbol]];
+		while (numOfBits >= 8) {
+			dst[length++] = (char)bits;
+			bits >>= 8;
+			numOfBits -= 8;
+		}
+	}
+
+	// The final state, then the bit that marks the end.
+	bits |= (unsigned long long)((state - TABLE_SIZE) | TABLE_SIZE) << numOfBits;
+	numOfBits += TABLE_LOG + 1;
+	while (numOfBits > 0) {
+		dst[length++] = (char)bits;
+		bits >>= 8;
+		numOfBits = numOfBits > 8 ? numOfBits - 8 : 0;
+	}
+	return length;
+} // encode
+
+// Desc: Return the 8 bytes of "src" at "index" as an integer (least
+//       significant first, as in memory), 0's past "srcSize".
+static inline unsigned long long loadBits(const unsigned char *src, unsigned index, unsigned srcSize) {
+	unsigned long long value = 0;
+	if (index + 8 <= srcSize) {
+		memcpy(&value, src + index, 8);
+	} else {
+		for (unsigned i = 0; index + i < srcSize; i++)
+			value |= (unsigned long long)src[index + i] << (8 * i);
+	}
+	return value;
+} // loadBits
+
+// Desc: Decode "size" symbols from the "srcSize" bytes of "src" into "dst".
+// Post: Return false if the data is not valid.
+bool Tans::decode(const char *src, unsigned srcSize, char *dst, unsigned size) const {
+	const unsigned char *data = (const unsigned char *)src;
+	if (srcSize == 0 || data[srcSize - 1] == 0)
+		return false;
+
+	// Bits before the end marker, read from the last to the first.
+	unsigned long long position = 8ULL * (srcSize - 1) + highestBit(data[srcSize - 1]);
+	if (position < TABLE_LOG)
+		return false;
+	position -= TABLE_LOG;
+	unsigned state = (unsigned)(loadBits(data, position >> 3, srcSize) >> (position & 7)) & (TABLE_SIZE - 1);
+
+	// Four symbols (at most 4 * TABLE_LOG bits) per load of 8 bytes, which
+	// hold at least 56 bits before "position".
+	unsigned i = 0;
+	for (; i + 4 <= size && position >= 64; i += 4) {
+		unsigned index = (unsigned)(position >> 3) - 7;
+		unsigned long long window;
+		memcpy(&window, data + index, 8);
+		unsigned shift = (unsigned)(position - 8ULL * index);
+		for (unsigned j = 0; j < 4; j++) {
+			const Entry &entry = entries[state];
+			dst[i + j] = entry.symbol;
+			shift -= entry.numOfBits;
+			state = entry.baseState + ((unsigned)(window >> shift) & ((1u << entry.numOfBits) - 1));
+		}
+		position = 8ULL * index + shift;
+	}
+
+	for (; i < size; i++) {
+		const Entry &entry = entries[state];
+		dst[i] = entry.symbol;
+		unsigned count = entry.numOfBits;
+		if (count > position)
+			return false;
+		position -= count;
+		unsigned value = (unsigned)(loadBits(data, position >> 3, srcSize) >> (position & 7)) & ((1u << count) - 1);
+		state = entry.baseState + value;
+	}
+	return position == 0;
+} // decode
+
+// End of Tans.cpp
@@ -0,0 +1,79 @@
+/*
+ * Tans.h
+ *
+ * Description: Table-based asymmetric numeral systems (tANS) coder.
+ *              The weights are scaled to 2^TABLE_LOG slots, which are
+ *              spread over a table of states. Each symbol costs
+ *              log2(2^TABLE_LOG / slots) bits on average, a fraction
+ *              of a bit where a Huffman code needs a whole one. The
+ *              decoder needs one table lookup and one read of a few bits
+ *              per symbol.
+ *
+ *              The symbols are coded from the last to the first, so that
+ *              the decoder reads the bits backwards, from the end of the
+ *              coded data to its start.
+ *
+ *
+ */
+
+#ifndef TANS_H
+#define TANS_H
+
+#include <vector>
+
+using namespace std;
+
+class Tans {
+private:
+	// Desc: One state of the decode table: the symbol it decodes, the
+	//       number of bits to read, and the next state before they are
+	//       added.
+	struct Entry {
+		unsigned short baseState;
+		unsigned char symbol;
+		unsigned char numOfBits;
+	};
+
+	unsigned numOfSymbols;
+	vector<unsigned> slots;				// Scaled weights, summing to 2^TABLE_LOG.
+	vector<unsigned> firstSlot;			// Index of the first state of each symbol in "encodeStates".
+	vector<unsigned short> encodeStates;	// States of each symbol, in the order of the decoder.
+	vector<Entry> entries;				// Decode table.
+
+	// Desc: Scale "weights" to 2^TABLE_LOG slots, at least one for each
+	//       symbol that occurs.
+	void normalize(const unsigned *weights);
+
+	// Copying a coder is not allowed.
+	Tans(const Tans &);
+	Tans &operator = (const Tans &);
+
+public:
+	// Number of bits of the states: the tables have 2^TABLE_LOG entries.
+	static const unsigned TABLE_LOG = 12;
+
+	// Desc: Constructor
+	//       Build the tables from the weights of "numOfSymbols" symbols.
+	//  Pre: numOfSymbols <= 256, and at least one weight is not 0.
+	Tans(const unsigned *weights, unsigned numOfSymbols);
+
+	// Desc: Return the number of bits encode() writes for symbols counted
+	//       in "weights" (the ones of the constructor), within a few bits.
+	unsigned long long getCodedBits(const unsigned *weights) const;
+
+	// Desc: Code the "size" symbols of "src" into "dst".
+	//  Pre: The symbols of "src" have a weight, and "dst" has room for
+	//       2 * size + 8 bytes.
+	// Post: Returns the number of bytes written.
+	unsigned encode(const unsigned char *src, unsigned size, char *dst) const;
+
+	// Desc: Decode "size" symbols from the "srcSize" bytes of "src"
+	//       into "dst".
+	// Post: Return false if the data is not valid.
+	bool decode(const char *src, unsigned srcSize, char *dst, unsigned size) const;
+
+}; // Tans
+
+#endif
+
+// End of Tans.h
@@ -0,0 +1,151 @@
+/*
+ * Trace.cpp
+ *
+ * Description: Event tracing for the pipeline and the worker threads.
+ *              Every thread appends to its own ring buffer without
+ *              locking; the mutex is only taken when a thread records
+ *              its first event and when the trace is written at exit.
+ *              When a ring buffer is full, the oldest events are
+ *              overwritten. The buffer of a thread that exits is handed
+ *              to the next new thread, so short-lived workers do not
+ *              add up.
+ *
+ *
+ */
+
+#ifdef HUFF_TRACE
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#include "Trace.h"
+
+using namespace std;
+
+// Number of events kept per thread.
+static const unsigned TRACE_RING_SIZE = 16 * 1024;
+
+// Desc: One complete event.
+struct TraceEvent {
+	const char *name;
+	unsigned arg;
+	unsigned long long start;		// Nanoseconds since the trace began.
+	unsigned long long duration;	// Nanoseconds.
+}; // TraceEvent
+
+// Desc: Ring buffer of the events of one thread.
+struct TraceRing {
+	unsigned threadId;				// 1, 2, ... in order of the first event.
+	unsigned long long count;		// Events recorded, including overwritten ones.
+	TraceEvent events[TRACE_RING_SIZE];
+}; // TraceRing
+
+// Desc: All ring buffers, written to the trace file on destruction
+//       (at program exit, after every worker thread has been joined).
+class TraceLog {
+private:
+	mutex lock;
+	vector<TraceRing *> rings;
+	vector<TraceRing *> freeRings;		// Rings of threads that have exited.
+	chrono::steady_clock::time_point origin;
+
+public:
+	TraceLog() : origin(chrono::steady_clock::now()) {}
+
+	~TraceLog() {
+		write();
+		for (size_t i = 0; i < rings.size(); i++)
+			delete rings[i];
+	}
+
+	// Desc: Return the time since the trace began, in nanoseconds.
+	unsigned long long now() const {
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+	}
+
+	// Desc: Return a ring buffer for the calling thread.
+	TraceRing *acquireRing() {
+		lock_guard<mutex> guard(lock);
+		if (!freeRings.empty()) {
+			TraceRing *ring = freeRings.back();
+			freeRings.pop_back();
+			return ring;
+		}
+		TraceRing *ring = new TraceRing;
+		ring -> count = 0;
+		rings.push_back(ring);
+		ring -> threadId = rings.size();
+		return ring;
+	}
+
+	// Desc: Hand the ring buffer of an exiting thread to the next thread.
+	void releaseRing(TraceRing *ring) {
+		lock_guard<mutex> guard(lock);
+		freeRings.push_back(ring);
+	}
+
+	// Desc: Write the events as Chrome trace JSON ("X" complete events).
+	void write() {
+		lock_guard<mutex> guard(lock);
+		const char *fileName = getenv("HUFF_TRACE_FILE");
+		FILE *file = fopen(fileName != NULL ? fileName : "huff_trace.json", "w");
+		if (file == NULL)
+			return;
+
+		fprintf(file, "{\"traceEvents\": [\n");
+		bool isFirst = true;
+		for (size_t i = 0; i < rings.size(); i++) {
+			TraceRing *ring = rings[i];
+			unsigned long long first = ring -> count > TRACE_RING_SIZE ? ring -> count - TRACE_RING_SIZE : 0;
+			for (unsigned long long j = first; j < ring -> count; j++) {
+				const TraceEvent &event = ring -> events[j % TRACE_RING_SIZE];
+				fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"n\": %u}}",
+					isFirst ? "" : ",\n", event.name, ring -> threadId,
+					event.start / 1000.0, event.duration / 1000.0, event.arg);
+				isFirst = false;
+			}
+		}
+		fprintf(file, "\n], \"displayTimeUnit\": \"ms\"}\n");
+		fclose(file);
+	}
+}; // TraceLog
+
+static TraceLog traceLog;
+
+// Desc: The ring buffer of one thread, released when the thread exits.
+struct LocalRing {
+	TraceRing *ring;
+	LocalRing() : ring(NULL) {}
+	~LocalRing() {
+		if (ring != NULL)
+			traceLog.releaseRing(ring);
+	}
+}; // LocalRing
+
+static thread_local LocalRing localRing;
+
+// Desc: Constructor
+//       The event begins at construction and ends at destruction.
+TraceScope::TraceScope(const char *name, unsigned arg) : name(name), arg(arg) {
+	start = traceLog.now();
+} // Constructor
+
+// Desc: Destructor
+//       Append the event to the ring buffer of the calling thread.
+TraceScope::~TraceScope() {
+	if (localRing.ring == NULL)
+		localRing.ring = traceLog.acquireRing();
+	TraceRing *ring = localRing.ring;
+	TraceEvent &event = ring -> events[ring -> count % TRACE_RING_SIZE];
+	event.name = name;
+	event.arg = arg;
+	event.start = start;
+	event.duration = traceLog.now() - start;
+	ring -> count++;
+} // Destructor
+
+#endif
+
+// End of Trace.cpp
@@ -0,0 +1,60 @@
+/*
+ * Trace.h
+ *
+ * Description: Event tracing for the pipeline and the worker threads.
+ *              TRACE_SCOPE("name") records when the enclosing scope
+ *              begins and ends, on the calling thread. The events are
+ *              kept in a fixed-size ring buffer per thread and written
+ *              as Chrome trace JSON (chrome://tracing, Perfetto) when
+ *              the program exits.
+ *
+ *              Tracing is only compiled in when HUFF_TRACE is defined
+ *              ("make TRACE=1"). Otherwise the macros expand to nothing.
+ *              The output file is named by the HUFF_TRACE_FILE
+ *              environment variable, "huff_trace.json" by default.
+ *
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef HUFF_TRACE
+
+// Desc: Records one complete event covering its own lifetime.
+class TraceScope {
+private:
+	const char *name;				// Must be a string literal.
+	unsigned arg;					// Block or chunk number.
+	unsigned long long start;		// Nanoseconds since the trace began.
+
+	// Copying a scope is not allowed.
+	TraceScope(const TraceScope &);
+	TraceScope &operator = (const TraceScope &);
+
+public:
+	// Constructor and destructor
+	//       The event begins at construction and ends at destruction.
+	TraceScope(const char *name, unsigned arg = 0);
+	~TraceScope();
+}; // TraceScope
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+
+// Desc: Trace the rest of the enclosing scope.
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(traceScope, __LINE__)(name)
+
+// Desc: Trace the rest of the enclosing scope, tagged with a number.
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_JOIN(traceScope, __LINE__)(name, arg)
+
+#else
+
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_SCOPE_ARG(name, arg) do {} while (0)
+
+#endif
+
+#endif
+
+// End of Trace.h
@@ -0,0 +1,234 @@
+/*
+ * Trailer.cpp
+ *
+ * Description: Members of a compressed file. Data appended with
+ *              "huff -c --append" is coded as a new member, with its own
+ *              header and frequency table, and the trailer at the end of
+ *              the file lists where every member starts. Files joined
+ *              with "cat" are members too; they are found by reading
+ *              their headers one after another.
+ *
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include "Trailer.h"
+#include "FrequencyCounter.h"
+#include "CodeTableCache.h"
+#include "StreamDecoder.h"
+#include "HeaderFormat.h"
+
+using namespace std;
+
+// Desc: Parse the header at the beginning of the compressed data.
+//       Implemented in "FileHeaderHandler.cpp".
+int parseFileHeader(const char *, unsigned, FrequencyCounter &, unsigned &, unsigned &);
+int parseExtendedFileHeader(const char *, unsigned, char &, unsigned &, unsigned long long &, char &, unsigned &);
+
+// Size of a trailer without member offsets.
+static const unsigned TRAILER_FIXED_SIZE = 
+	BIT_FLAG + MEMBER_COUNT_SIZE + TRAILER_SIZE_SIZE + TRAILER_MAGIC_SIZE;
+
+// Size of the blocks read while decoding a member to find its end.
+static const unsigned SCAN_BLOCK_SIZE = 64 * 1024;
+
+// Desc: Convert "valueSize" bytes of data to a value.
+static unsigned long long readValue(const char *data, unsigned valueSize) {
+	unsigned long long value = 0;
+	memcpy(&value, data, valueSize);
+	return value;
+} // readValue
+
+// Desc: Find the indexed members of the compressed file "fileName".
+// Post: Return false if the file cannot be opened. Otherwise, "offsets"
+//       holds the offset of every member listed in the trailer and
+//       "dataEnd" the end of the last one, where the trailer starts.
+//       Without a trailer, "offsets" is empty and "dataEnd" is the file
+//       size. Members before the first listed one are not indexed.
+bool readTrailer(const char *fileName, vector<unsigned long long> &offsets, unsigned long long &dataEnd) {
+	ifstream fin(fileName, ios::in | ios::binary);
+	if (!fin.is_open())
+		return false;
+
+	fin.seekg(0, ios::end);
+	unsigned long long fileSize = fin.tellg();
+	offsets.clear();
+	dataEnd = fileSize;
+	if (fileSize < TRAILER_FIXED_SIZE)
+		return true;
+
+	// The trailer size and the magic are the last bytes of the file.
+	char end[TRAILER_SIZE_SIZE + TRAILER_MAGIC_SIZE];
+	fin.seekg(fileSize - sizeof(end), ios::beg);
+	fin.read(end, sizeof(end));
+	if (!fin || memcmp(end + TRAILER_SIZE_SIZE, TRAILER_MAGIC, TRAILER_MAGIC_SIZE) != 0)
+		return true;
+	unsigned trailerSize = readValue(end, TRAILER_SIZE_SIZE);
+	if (trailerSize < TRAILER_FIXED_SIZE || trailerSize > fileSize)
+		return true;
+
+	vector<char> trailer(trailerSize);
+	fin.seekg(fileSize - trailerSize, ios::beg);
+	fin.read(trailer.data(), trailerSize);
+	if (!fin || trailer[0] != TRAILER_FLAG)
+		return true;
+	unsigned numOfMembers = readValue(trailer.data() + BIT_FLAG, MEMBER_COUNT_SIZE);
+	if (numOfMembers == 0 || trailerSize != TRAILER_FIXED_SIZE + (unsigned long long)numOfMembers * MEMBER_OFFSET_SIZE)
+		return true;
+
+	// The members start in increasing order, before the trailer.
+	unsigned long long trailerStart = fileSize - trailerSize;
+	vector<unsigned long long> members;
+	const char *pos = trailer.data() + BIT_FLAG + MEMBER_COUNT_SIZE;
+	for (unsigned i = 0; i < numOfMembers; i++, pos += MEMBER_OFFSET_SIZE) {
+		unsigned long long distance = readValue(pos, MEMBER_OFFSET_SIZE);
+		if (distance == 0 || distance > trailerStart)
+			return true;
+		unsigned long long offset = trailerStart - distance;
+		if (i > 0 && offset <= members.back())
+			return true;
+		members.push_back(offset);
+	}
+
+	offsets.swap(members);
+	dataEnd = trailerStart;
+	return true;
+} // readTrailer
+
+// Desc: Write a trailer listing the members at "offsets". The trailer
+//       starts at "dataEnd".
+// Post: Return the size of the trailer (in bytes).
+unsigned writeTrailer(OutBitStream &out, const vector<unsigned long long> &offsets, unsigned long long dataEnd) {
+	unsigned trailerSize = TRAILER_FIXED_SIZE + offsets.size() * MEMBER_OFFSET_SIZE;
+	out.writeByte(TRAILER_FLAG);
+	out.writeValue(offsets.size(), MEMBER_COUNT_SIZE);
+	for (unsigned i = 0; i < offsets.size(); i++) {
+		unsigned long long distance = dataEnd - offsets[i];
+		out.writeBlock((const char *)&distance, MEMBER_OFFSET_SIZE);
+	}
+	out.writeValue(trailerSize, TRAILER_SIZE_SIZE);
+	out.writeBlock(TRAILER_MAGIC, TRAILER_MAGIC_SIZE);
+	return trailerSize;
+} // writeTrailer
+
+// Desc: Return the size of the trailer starting at "offset" in
+//       "fileName", or 0 if there is none. Files joined with "cat" may
+//       have trailers between their members.
+unsigned getTrailerSizeAt(const char *fileName, unsigned long long offset) {
+	ifstream fin(fileName, ios::in | ios::binary);
+	char start[BIT_FLAG + MEMBER_COUNT_SIZE];
+	fin.seekg(offset, ios::beg);
+	fin.read(start, sizeof(start));
+
+	// A file header never has every bit of the bit flag set.
+	if (!fin || start[0] != TRAILER_FLAG)
+		return 0;
+	unsigned long long trailerSize = TRAILER_FIXED_SIZE + 
+		readValue(start + BIT_FLAG, MEMBER_COUNT_SIZE) * MEMBER_OFFSET_SIZE;
+
+	char end[TRAILER_SIZE_SIZE + TRAILER_MAGIC_SIZE];
+	fin.seekg(offset + trailerSize - sizeof(end), ios::beg);
+	fin.read(end, sizeof(end));
+	if (!fin || readValue(end, TRAILER_SIZE_SIZE) != trailerSize || 
+		memcmp(end + TRAILER_SIZE_SIZE, TRAILER_MAGIC, TRAILER_MAGIC_SIZE) != 0)
+		return 0;
+	return trailerSize;
+} // getTrailerSizeAt
+
+// Desc: Read the header of the member starting at "offset" in "fileName".
+// Post: Return false if it is not a valid header.
+bool readMemberHeader(const char *fileName, unsigned long long offset, MemberInfo &member) {
+	ifstream fin(fileName, ios::in | ios::binary);
+	char header[MAX_HEADER_SIZE];
+	fin.seekg(offset, ios::beg);
+	fin.read(header, MAX_HEADER_SIZE);
+
+	// An extended header gives the body size.
+	member.offset = offset;
+	member.tableId = 0;
+	member.method = 0;
+	char filterType;
+	unsigned stride;
+	int headerSize = parseExtendedFileHeader(header, fin.gcount(), member.method, member.originalSize, member.bodySize,
+		filterType, stride);
+	if (headerSize != 0) {
+		member.headerSize = headerSize;
+		return true;
+	}
+
+	FrequencyCounter counter;
+	headerSize = parseFileHeader(header, fin.gcount(), counter, member.tableId, member.originalSize);
+	if (headerSize == 0 || header[0] == TRAILER_FLAG)
+		return false;
+
+	member.headerSize = headerSize;
+	member.bodySize = 0;
+	if (member.tableId == 0) {
+		HuffmanCode code(counter);
+		member.bodySize = code.getEncodedSize(counter.getBitVector());
+	}
+	return true;
+} // readMemberHeader
+
+// Desc: Decode the member starting at "offset" in "fileName", only
+//       to find where it ends.
+// Post: Return false if the data is not valid. Otherwise, "end" is
+//       the offset right after the member.
+static bool skipMember(const char *fileName, unsigned long long offset, const Options &opt, unsigned long long &end) {
+	ifstream fin(fileName, ios::in | ios::binary);
+	fin.seekg(offset, ios::beg);
+
+	StreamDecoder decoder(opt);
+	vector<char> inBuffer(SCAN_BLOCK_SIZE), outBuffer(SCAN_BLOCK_SIZE);
+	StreamDecoder::Status status = StreamDecoder::NEED_INPUT;
+	unsigned consumed, produced;
+	end = offset;
+	while (status == StreamDecoder::NEED_INPUT || status == StreamDecoder::OUTPUT_FULL) {
+		fin.read(inBuffer.data(), SCAN_BLOCK_SIZE);
+		unsigned available = fin.gcount();
+		if (available == 0)
+			return false;	// The data ends too early.
+		const char *pos = inBuffer.data();
+		do {
+			status = decoder.decode(pos, available, consumed, outBuffer.data(), SCAN_BLOCK_SIZE, produced);
+			pos += consumed;
+			available -= consumed;
+			end += consumed;
+		} while (status == StreamDecoder::OUTPUT_FULL || (status == StreamDecoder::NEED_INPUT && available > 0));
+	}
+	if (status == StreamDecoder::MISSING_TABLE)
+		cout << "Error: \"" << fileName << "\" requires the static table " << decoder.getTableId() << "." << endl;
+	return status == StreamDecoder::FINISHED;
+} // skipMember
+
+// Desc: Find the members between "from" and "to" in "fileName", skipping
+//       any trailers. The size of a member follows from its frequency
+//       table; members coded with a static table ("opt.tableFile") are
+//       decoded to find their end.
+// Post: Return false if the data is not valid. Otherwise, the offsets
+//       of the members are appended to "offsets".
+bool findMembers(const char *fileName, unsigned long long from, unsigned long long to, 
+	const Options &opt, vector<unsigned long long> &offsets) {
+	unsigned long long pos = from;
+	while (pos < to) {
+		unsigned trailerSize = getTrailerSizeAt(fileName, pos);
+		if (trailerSize != 0) {
+			pos += trailerSize;
+			continue;
+		}
+
+		MemberInfo member;
+		if (readMemberHeader(fileName, pos, member) == false)
+			return false;
+		offsets.push_back(pos);
+		if (member.tableId == 0)
+			pos += member.headerSize + member.bodySize;
+		else if (skipMember(fileName, pos, opt, pos) == false)
+			return false;
+	}
+	return pos == to;
+} // findMembers
+
+// End of Trailer.cpp
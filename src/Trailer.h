@@ -0,0 +1,67 @@
+/*
+ * Trailer.h
+ *
+ * Description: Members of a compressed file. Data appended with
+ *              "huff -c --append" is coded as a new member, with its own
+ *              header and frequency table, and the trailer at the end of
+ *              the file lists where every member starts. Files joined
+ *              with "cat" are members too; they are found by reading
+ *              their headers one after another.
+ *
+ *
+ */
+
+#ifndef TRAILER_H
+#define TRAILER_H
+
+#include <vector>
+#include "OutBitStream.h"
+#include "Options.h"
+
+using namespace std;
+
+// Desc: Header of one member.
+class MemberInfo {
+public:
+	unsigned long long offset;		// Where the member starts.
+	unsigned headerSize;			// Including the original size field.
+	unsigned originalSize;			// Size of the decompressed data.
+	unsigned tableId;				// Id of the static table, 0 if none.
+	unsigned long long bodySize;	// Only known if "tableId" is 0.
+	char method;					// Method of an extended header, 0 if none.
+}; // MemberInfo
+
+// Desc: Find the indexed members of the compressed file "fileName".
+// Post: Return false if the file cannot be opened. Otherwise, "offsets"
+//       holds the offset of every member listed in the trailer and
+//       "dataEnd" the end of the last one, where the trailer starts.
+//       Without a trailer, "offsets" is empty and "dataEnd" is the file
+//       size. Members before the first listed one are not indexed.
+bool readTrailer(const char *fileName, vector<unsigned long long> &offsets, unsigned long long &dataEnd);
+
+// Desc: Write a trailer listing the members at "offsets". The trailer
+//       starts at "dataEnd".
+// Post: Return the size of the trailer (in bytes).
+unsigned writeTrailer(OutBitStream &out, const vector<unsigned long long> &offsets, unsigned long long dataEnd);
+
+// Desc: Return the size of the trailer starting at "offset" in
+//       "fileName", or 0 if there is none. Files joined with "cat" may
+//       have trailers between their members.
+unsigned getTrailerSizeAt(const char *fileName, unsigned long long offset);
+
+// Desc: Read the header of the member starting at "offset" in "fileName".
+// Post: Return false if it is not a valid header.
+bool readMemberHeader(const char *fileName, unsigned long long offset, MemberInfo &member);
+
+// Desc: Find the members between "from" and "to" in "fileName", skipping
+//       any trailers. The size of a member follows from its frequency
+//       table; members coded with a static table ("opt.tableFile") are
+//       decoded to find their end.
+// Post: Return false if the data is not valid. Otherwise, the offsets
+//       of the members are appended to "offsets".
+bool findMembers(const char *fileName, unsigned long long from, unsigned long long to, 
+	const Options &opt, vector<unsigned long long> &offsets);
+
+#endif
+
+// End of Trailer.h
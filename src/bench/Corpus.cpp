@@ -0,0 +1,169 @@
+/*
+ * Corpus.cpp
+ *
+ * Description: Reproducible benchmark data.
+ *              Every generator is driven by its own fixed-seed random
+ *              number generator, so the same data is produced on every
+ *              machine and every run.
+ *
+ *
+ */
+
+#include <cstdio>
+#include "Corpus.h"
+
+using namespace std;
+
+const char *const CORPUS_NAMES[] = { "text", "logs", "random", "zeros", "skewed", "tiny" };
+const unsigned NUM_OF_CORPUS_NAMES = 6;
+
+// Vocabulary of the "text" data set, roughly in order of frequency.
+static const char *const WORDS[] = {
+	"the", "of", "and", "to", "a", "in", "is", "that", "for", "it", "as", "was",
+	"with", "be", "by", "on", "not", "he", "this", "are", "or", "his", "from",
+	"at", "which", "but", "have", "an", "had", "they", "you", "were", "their",
+	"one", "all", "we", "can", "her", "has", "there", "been", "if", "more",
+	"when", "will", "would", "who", "so", "no", "compression", "huffman",
+	"frequency", "table", "tree", "code", "stream", "buffer", "file", "data"
+};
+static const unsigned NUM_OF_WORDS = sizeof(WORDS) / sizeof(WORDS[0]);
+
+// Values used by the "logs" data set.
+static const char *const LEVELS[] = { "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR" };
+static const char *const PATHS[] = { "/api/v1/users", "/api/v1/orders", "/health", "/api/v2/search", "/static/app.js" };
+
+// Desc: Constructor
+Random::Random(unsigned long long seed) {
+	state = seed * 2685821657736338717ull + 1;
+} // Constructor
+
+// Desc: Return the next 64-bit random value.
+unsigned long long Random::next() {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 2685821657736338717ull;
+} // next
+
+// Desc: Return a random value in [0, bound).
+unsigned Random::nextBelow(unsigned bound) {
+	return (unsigned)((next() >> 32) % bound);
+} // nextBelow
+
+// Desc: Append "text" to "data" without exceeding "size" bytes.
+static void append(vector<char> &data, const char *text, unsigned size) {
+	while (*text != '\0' && data.size() < size)
+		data.push_back(*text++);
+} // append
+
+// Desc: English-like text with a Zipf-like word distribution.
+static void generateText(unsigned size, Random &random, vector<char> &data) {
+	unsigned wordsInLine = 0;
+	while (data.size() < size) {
+		// Skew towards the first words of the vocabulary.
+		unsigned index = random.nextBelow(NUM_OF_WORDS);
+		index = index * random.nextBelow(NUM_OF_WORDS) / NUM_OF_WORDS;
+		append(data, WORDS[index], size);
+		if (++wordsInLine == 12) {
+			append(data, ".\n", size);
+			wordsInLine = 0;
+		} else {
+			append(data, " ", size);
+		}
+	}
+} // generateText
+
+// Desc: Access-log lines with timestamps, levels and numbers.
+static void generateLogs(unsigned size, Random &random, vector<char> &data) {
+	char line[256];
+	unsigned seconds = 0;
+	while (data.size() < size) {
+		seconds += random.nextBelow(3);
+		snprintf(line, sizeof(line),
+			"2024-03-%02u %02u:%02u:%02u.%03u %-5s [worker-%u] GET %s status=%u latency_ms=%u request_id=%08x\n",
+			1 + seconds / 86400 % 28, seconds / 3600 % 24, seconds / 60 % 60, seconds % 60,
+			random.nextBelow(1000), LEVELS[random.nextBelow(6)], random.nextBelow(16),
+			PATHS[random.nextBelow(5)], random.nextBelow(10) == 0 ? 500 : 200,
+			random.nextBelow(250), (unsigned)random.next());
+		append(data, line, size);
+	}
+} // generateLogs
+
+// Desc: One small JSON record, like the messages on a message bus.
+static void generateRecord(unsigned size, Random &random, vector<char> &data) {
+	char record[256];
+	while (data.size() < size) {
+		snprintf(record, sizeof(record),
+			"{\"id\":%u,\"user\":\"user%u\",\"event\":\"%s\",\"level\":\"%s\",\"value\":%u.%02u}\n",
+			(unsigned)random.next() % 1000000, random.nextBelow(5000),
+			WORDS[random.nextBelow(NUM_OF_WORDS)], LEVELS[random.nextBelow(6)],
+			random.nextBelow(1000), random.nextBelow(100));
+		append(data, record, size);
+	}
+} // generateRecord
+
+// Desc: Generate "size" bytes of the data set called "name".
+//       "tiny" produces a single small record; use "seed" to vary it.
+// Post: Return false if "name" is unknown.
+bool generateCorpus(const string &name, unsigned size, unsigned long long seed, vector<char> &data) {
+	Random random(seed);
+	data.clear();
+	data.reserve(size);
+
+	if (name == "text") {
+		generateText(size, random, data);
+	} else if (name == "logs") {
+		generateLogs(size, random, data);
+	} else if (name == "random") {
+		while (data.size() < size)
+			data.push_back((char)random.next());
+	} else if (name == "zeros") {
+		data.assign(size, 0);
+	} else if (name == "skewed") {
+		// Geometric distribution: each value is half as likely as the previous one.
+		while (data.size() < size) {
+			unsigned long long bits = random.next();
+			char value = 0;
+			while ((bits & 1) != 0 && value < 63) {
+				value++;
+				bits >>= 1;
+			}
+			data.push_back(value);
+		}
+	} else if (name == "tiny") {
+		generateRecord(size, random, data);
+	} else {
+		return false;
+	}
+	return true;
+} // generateCorpus
+
+// Desc: Fill "data" with "size" bytes following the given histogram
+//       (256 weights, not all zero).
+void generateFromHistogram(const unsigned *weights, unsigned size, unsigned long long seed, vector<char> &data) {
+	Random random(seed);
+
+	// Cumulative weights, searched with a binary search.
+	unsigned long long cumulative[256];
+	unsigned long long total = 0;
+	for (int i = 0; i < 256; i++) {
+		total += weights[i];
+		cumulative[i] = total;
+	}
+
+	data.resize(size);
+	for (unsigned i = 0; i < size; i++) {
+		unsigned long long target = random.next() % total;
+		int low = 0, high = 255;
+		while (low < high) {
+			int mid = (low + high) / 2;
+			if (cumulative[mid] > target)
+				high = mid;
+			else
+				low = mid + 1;
+		}
+		data[i] = (char)(low - 128);
+	}
+} // generateFromHistogram
+
+// End of Corpus.cpp
@@ -0,0 +1,51 @@
+/*
+ * Corpus.h
+ *
+ * Description: Reproducible benchmark data.
+ *              Every generator is driven by its own fixed-seed random
+ *              number generator, so the same data is produced on every
+ *              machine and every run.
+ *
+ *
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Desc: Small, fast and portable random number generator (xorshift64*).
+class Random {
+private:
+	unsigned long long state;
+public:
+	// Constructor
+	Random(unsigned long long seed);
+
+	// Desc: Return the next 64-bit random value.
+	unsigned long long next();
+
+	// Desc: Return a random value in [0, bound).
+	unsigned nextBelow(unsigned bound);
+}; // Random
+
+// Desc: Names of the generated data sets:
+//       "text", "logs", "random", "zeros", "skewed" and "tiny".
+extern const char *const CORPUS_NAMES[];
+extern const unsigned NUM_OF_CORPUS_NAMES;
+
+// Desc: Generate "size" bytes of the data set called "name".
+//       "tiny" produces a single small record; use "seed" to vary it.
+// Post: Return false if "name" is unknown.
+bool generateCorpus(const string &name, unsigned size, unsigned long long seed, vector<char> &data);
+
+// Desc: Fill "data" with "size" bytes following the given histogram
+//       (256 weights, not all zero).
+void generateFromHistogram(const unsigned *weights, unsigned size, unsigned long long seed, vector<char> &data);
+
+#endif
+
+// End of Corpus.h
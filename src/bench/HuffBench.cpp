@@ -0,0 +1,414 @@
+/*
+ * HuffBench.cpp
+ *
+ * Description: End-to-end benchmark of compression and decompression.
+ *              A reproducible corpus (or the files of a directory) is
+ *              compressed and decompressed several times, and the
+ *              throughput, ratio and latency percentiles of each data
+ *              set are reported as JSON. A report can be saved as a
+ *              baseline and compared against later runs, so that a
+ *              change is only kept if it does not slow anything down.
+ *
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "Corpus.h"
+#include "Options.h"
+
+using namespace std;
+
+// Desc: Compression and Decompression functions.
+//       Implemented in "Compress.cpp" and "Decompress.cpp" repectively.
+int compress(const char *src, const char *dst, const Options &opt);
+int decompress(const char *src, const char *dst, const Options &opt);
+
+// Number of files of the "tiny" data set and their size range.
+static const unsigned NUM_OF_TINY_FILES = 200;
+static const unsigned MIN_TINY_SIZE = 64;
+static const unsigned MAX_TINY_SIZE = 1024;
+
+// Desc: Settings of a benchmark run.
+struct BenchOptions {
+	string dir;				// Working directory for the generated files.
+	string corpusDir;		// Benchmark these files instead of the generated corpus.
+	unsigned size;			// Size of each generated data set, in bytes.
+	unsigned repeat;		// Number of timed runs per data set.
+	string output;			// Save the report to this file.
+	string baseline;		// Compare the report against this file.
+	double tolerance;		// Allowed slowdown before reporting a regression, in percent.
+	Options opt;			// Options passed to compress() and decompress().
+
+	BenchOptions() : dir("/tmp/huffbench"), size(16 << 20), repeat(5), tolerance(5.0) {}
+}; // BenchOptions
+
+// Desc: Measurements of one data set.
+struct BenchResult {
+	string name;
+	unsigned long long bytes;
+	unsigned long long compressed;
+	vector<double> compressTimes;	// Seconds per run.
+	vector<double> decompressTimes;
+}; // BenchResult
+
+// Desc: One data set: the files that are compressed in each run.
+struct DataSet {
+	string name;
+	vector<string> files;
+}; // DataSet
+
+// Desc: display the usage of the benchmark.
+void helpMessage() {
+	cout << "Usage:\thuffbench [-options]" << endl;
+	cout << "Options:\t--dir [Dir]" << "\t\t" << "Working directory for the generated files (default /tmp/huffbench)." << endl;
+	cout << "\t\t--size [MB]" << "\t\t" << "Size of each generated data set (default 16)." << endl;
+	cout << "\t\t--corpus [Dir]" << "\t\t" << "Benchmark the files of a directory instead of the generated corpus." << endl;
+	cout << "\t\t--repeat [N]" << "\t\t" << "Number of timed runs per data set (default 5)." << endl;
+	cout << "\t\t-j, --threads [N]" << "\t" << "Compress / decompress with N threads." << endl;
+	cout << "\t\t--pipeline" << "\t\t" << "Use pipelined compression / decompression." << endl;
+	cout << "\t\t--output [File]" << "\t\t" << "Save the JSON report to a file." << endl;
+	cout << "\t\t--compare [File]" << "\t" << "Compare against a saved report and fail on regressions." << endl;
+	cout << "\t\t--tolerance [%]" << "\t\t" << "Allowed slowdown or ratio loss (default 5)." << endl;
+}
+
+// Desc: Parse the command line.
+// Post: Return true if all options are recognized. Otherwise, return false.
+bool parseOptions(int argc, char *argv[], BenchOptions &bench) {
+	for (int i = 1; i < argc; i++) {
+		string option = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (option == "--dir" && hasValue) {
+			bench.dir = argv[++i];
+		} else if (option == "--size" && hasValue && atoi(argv[i + 1]) > 0) {
+			bench.size = (unsigned)atoi(argv[++i]) << 20;
+		} else if (option == "--corpus" && hasValue) {
+			bench.corpusDir = argv[++i];
+		} else if (option == "--repeat" && hasValue && atoi(argv[i + 1]) > 0) {
+			bench.repeat = atoi(argv[++i]);
+		} else if ((option == "-j" || option == "--threads") && hasValue && atoi(argv[i + 1]) > 0) {
+			bench.opt.numOfThreads = atoi(argv[++i]);
+		} else if (option == "--pipeline") {
+			bench.opt.pipeline = true;
+		} else if (option == "--output" && hasValue) {
+			bench.output = argv[++i];
+		} else if (option == "--compare" && hasValue) {
+			bench.baseline = argv[++i];
+		} else if (option == "--tolerance" && hasValue) {
+			bench.tolerance = atof(argv[++i]);
+		} else {
+			cout << "Error: Unrecognized option \'" << option << "\'." << endl;
+			return false;
+		}
+	}
+	return true;
+} // parseOptions
+
+// Desc: Write "data" to "file".
+// Post: Return true if success. Otherwise, return false.
+bool writeFile(const string &file, const vector<char> &data) {
+	ofstream out(file.c_str(), ios::out | ios::binary);
+	out.write(data.data(), data.size());
+	return out.good();
+} // writeFile
+
+// Desc: Read the whole "file" into "data".
+// Post: Return true if success. Otherwise, return false.
+bool readFile(const string &file, vector<char> &data) {
+	ifstream in(file.c_str(), ios::in | ios::binary);
+	if (!in.is_open())
+		return false;
+	data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	return true;
+} // readFile
+
+// Desc: Return the size of "file", 0 if it does not exist.
+unsigned long long fileSize(const string &file) {
+	struct stat info;
+	return stat(file.c_str(), &info) == 0 ? info.st_size : 0;
+} // fileSize
+
+// Desc: Generate the reproducible corpus in "bench.dir".
+// Post: Return false if a file cannot be written.
+bool generateDataSets(const BenchOptions &bench, vector<DataSet> &dataSets) {
+	mkdir(bench.dir.c_str(), 0755);
+	vector<char> data;
+
+	for (unsigned i = 0; i < NUM_OF_CORPUS_NAMES; i++) {
+		DataSet dataSet;
+		dataSet.name = CORPUS_NAMES[i];
+
+		if (dataSet.name == "tiny") {
+			string tinyDir = bench.dir + "/tiny";
+			mkdir(tinyDir.c_str(), 0755);
+			Random random(2024);
+			for (unsigned j = 0; j < NUM_OF_TINY_FILES; j++) {
+				unsigned size = MIN_TINY_SIZE + random.nextBelow(MAX_TINY_SIZE - MIN_TINY_SIZE + 1);
+				ostringstream file;
+				file << tinyDir << "/" << j << ".dat";
+				generateCorpus("tiny", size, j + 1, data);
+				if (writeFile(file.str(), data) == false)
+					return false;
+				dataSet.files.push_back(file.str());
+			}
+		} else {
+			string file = bench.dir + "/" + dataSet.name + ".dat";
+			generateCorpus(dataSet.name, bench.size, i + 1, data);
+			if (writeFile(file, data) == false)
+				return false;
+			dataSet.files.push_back(file);
+		}
+		dataSets.push_back(dataSet);
+	}
+	return true;
+} // generateDataSets
+
+// Desc: Use every regular file of "bench.corpusDir" as a data set.
+// Post: Return false if the directory cannot be read.
+bool loadDataSets(const BenchOptions &bench, vector<DataSet> &dataSets) {
+	DIR *dir = opendir(bench.corpusDir.c_str());
+	if (dir == NULL)
+		return false;
+
+	mkdir(bench.dir.c_str(), 0755);
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		string file = bench.corpusDir + "/" + entry -> d_name;
+		struct stat info;
+		if (stat(file.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+			continue;
+		DataSet dataSet;
+		dataSet.name = entry -> d_name;
+		dataSet.files.push_back(file);
+		dataSets.push_back(dataSet);
+	}
+	closedir(dir);
+
+	// Keep the report in a stable order.
+	sort(dataSets.begin(), dataSets.end(), [](const DataSet &a, const DataSet &b) { return a.name < b.name; });
+	return true;
+} // loadDataSets
+
+// Desc: Compress and decompress every file of "dataSet" once.
+// Post: Return false if an operation fails or the round trip does not
+//       reproduce the original data (checked when "verify" is true).
+bool runOnce(const BenchOptions &bench, const DataSet &dataSet, bool verify, BenchResult &result) {
+	string compressedFile = bench.dir + "/bench.huff";
+	string decompressedFile = bench.dir + "/bench.out";
+	double compressTime = 0, decompressTime = 0;
+	result.bytes = 0;
+	result.compressed = 0;
+
+	for (size_t i = 0; i < dataSet.files.size(); i++) {
+		const string &file = dataSet.files[i];
+
+		// Silence the progress messages while timing.
+		streambuf *console = cout.rdbuf(NULL);
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		int status = compress(file.c_str(), compressedFile.c_str(), bench.opt);
+		chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+		if (status != -1)
+			status = decompress(compressedFile.c_str(), decompressedFile.c_str(), bench.opt);
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		cout.rdbuf(console);
+
+		if (status == -1) {
+			cout << "Error: Cannot compress / decompress \"" << file << "\"." << endl;
+			return false;
+		}
+
+		compressTime += chrono::duration<double>(middle - start).count();
+		decompressTime += chrono::duration<double>(end - middle).count();
+		result.bytes += fileSize(file);
+		result.compressed += fileSize(compressedFile);
+
+		if (verify) {
+			vector<char> original, decompressed;
+			if (readFile(file, original) == false || readFile(decompressedFile, decompressed) == false || original != decompressed) {
+				cout << "Error: Round trip of \"" << file << "\" does not match the original." << endl;
+				return false;
+			}
+		}
+	}
+
+	result.compressTimes.push_back(compressTime);
+	result.decompressTimes.push_back(decompressTime);
+	return true;
+} // runOnce
+
+// Desc: Return the "percent" percentile of "times" (nearest rank).
+double percentile(vector<double> times, double percent) {
+	sort(times.begin(), times.end());
+	size_t rank = (size_t)(percent / 100.0 * times.size() + 0.999999);
+	rank = rank < 1 ? 1 : (rank > times.size() ? times.size() : rank);
+	return times[rank - 1];
+} // percentile
+
+// Desc: Return the throughput in MB/s, based on the median time.
+double throughput(unsigned long long bytes, const vector<double> &times) {
+	double median = percentile(times, 50);
+	return median > 0 ? bytes / median / (1 << 20) : 0;
+} // throughput
+
+// Desc: Return the compression ratio (compressed / original).
+double compressionRatio(const BenchResult &result) {
+	return result.bytes > 0 ? (double)result.compressed / result.bytes : 0;
+} // compressionRatio
+
+// Desc: Write the report as JSON, one data set per line.
+void writeReport(ostream &out, const BenchOptions &bench, const vector<BenchResult> &results) {
+	char line[512];
+	out << "{\"repeat\": " << bench.repeat << ", \"threads\": " << bench.opt.numOfThreads
+		<< ", \"pipeline\": " << (bench.opt.pipeline ? "true" : "false") << ", \"results\": [" << endl;
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult &result = results[i];
+		snprintf(line, sizeof(line),
+			"  {\"name\": \"%s\", \"bytes\": %llu, \"compressed\": %llu, \"ratio\": %.4f, "
+			"\"compress_mbps\": %.2f, \"decompress_mbps\": %.2f, "
+			"\"compress_ms\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f}, "
+			"\"decompress_ms\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f}}%s",
+			result.name.c_str(), result.bytes, result.compressed, compressionRatio(result),
+			throughput(result.bytes, result.compressTimes), throughput(result.bytes, result.decompressTimes),
+			percentile(result.compressTimes, 50) * 1000, percentile(result.compressTimes, 90) * 1000,
+			percentile(result.compressTimes, 99) * 1000,
+			percentile(result.decompressTimes, 50) * 1000, percentile(result.decompressTimes, 90) * 1000,
+			percentile(result.decompressTimes, 99) * 1000,
+			i + 1 < results.size() ? "," : "");
+		out << line << endl;
+	}
+	out << "]}" << endl;
+} // writeReport
+
+// Desc: Find "key" in a line of a report and parse the value after it.
+// Post: Return the text of the value, empty if "key" is missing.
+string findValue(const string &line, const string &key) {
+	size_t pos = line.find("\"" + key + "\": ");
+	if (pos == string::npos)
+		return "";
+	pos += key.size() + 4;
+	size_t end = line.find_first_of(",}", pos);
+	string value = line.substr(pos, end - pos);
+	if (value.size() >= 2 && value[0] == '\"')
+		value = value.substr(1, value.size() - 2);
+	return value;
+} // findValue
+
+// Desc: Compare the results against the report saved in "bench.baseline".
+//       Throughput may not drop, and the ratio may not grow, by more
+//       than "bench.tolerance" percent.
+// Post: Return the number of regressions, or -1 if the baseline cannot be read.
+int compareBaseline(const BenchOptions &bench, const vector<BenchResult> &results) {
+	ifstream in(bench.baseline.c_str());
+	if (!in.is_open()) {
+		cout << "Error: Cannot open baseline \"" << bench.baseline << "\"." << endl;
+		return -1;
+	}
+
+	int regressions = 0;
+	double slack = bench.tolerance / 100.0;
+	string line;
+	while (getline(in, line)) {
+		string name = findValue(line, "name");
+		if (name.empty())
+			continue;
+
+		const BenchResult *result = NULL;
+		for (size_t i = 0; i < results.size(); i++)
+			if (results[i].name == name)
+				result = &results[i];
+		if (result == NULL) {
+			cout << name << ": not in this run" << endl;
+			continue;
+		}
+
+		// Metric name, baseline value, new value and whether higher is better.
+		struct { const char *key; double before, after; bool higherIsBetter; } metrics[] = {
+			{ "compress_mbps", atof(findValue(line, "compress_mbps").c_str()), throughput(result -> bytes, result -> compressTimes), true },
+			{ "decompress_mbps", atof(findValue(line, "decompress_mbps").c_str()), throughput(result -> bytes, result -> decompressTimes), true },
+			{ "ratio", atof(findValue(line, "ratio").c_str()), compressionRatio(*result), false }
+		};
+		for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+			double before = metrics[i].before, after = metrics[i].after;
+			if (before <= 0)
+				continue;
+			double change = (after - before) / before * 100.0;
+			bool regressed = metrics[i].higherIsBetter ? after < before * (1 - slack) : after > before * (1 + slack);
+			char text[256];
+			snprintf(text, sizeof(text), "%-12s %-16s %10.4f -> %10.4f (%+.1f%%)%s",
+				name.c_str(), metrics[i].key, before, after, change, regressed ? "  REGRESSION" : "");
+			cout << text << endl;
+			if (regressed)
+				regressions++;
+		}
+	}
+	return regressions;
+} // compareBaseline
+
+// Desc: main function
+int main(int argc, char *argv[]) {
+	BenchOptions bench;
+	if (parseOptions(argc, argv, bench) == false) {
+		helpMessage();
+		return 1;
+	}
+
+	vector<DataSet> dataSets;
+	if (!bench.corpusDir.empty()) {
+		if (loadDataSets(bench, dataSets) == false) {
+			cout << "Error: Cannot read corpus directory \"" << bench.corpusDir << "\"." << endl;
+			return 1;
+		}
+	} else if (generateDataSets(bench, dataSets) == false) {
+		cout << "Error: Cannot write the corpus to \"" << bench.dir << "\"." << endl;
+		return 1;
+	}
+
+	vector<BenchResult> results;
+	for (size_t i = 0; i < dataSets.size(); i++) {
+		BenchResult result;
+		result.name = dataSets[i].name;
+		// The first (untimed) run warms the caches and checks the round trip.
+		if (runOnce(bench, dataSets[i], true, result) == false)
+			return 1;
+		result.compressTimes.clear();
+		result.decompressTimes.clear();
+		for (unsigned j = 0; j < bench.repeat; j++) {
+			if (runOnce(bench, dataSets[i], false, result) == false)
+				return 1;
+		}
+		results.push_back(result);
+	}
+
+	writeReport(cout, bench, results);
+	if (!bench.output.empty()) {
+		ofstream out(bench.output.c_str());
+		writeReport(out, bench, results);
+		if (!out.good()) {
+			cout << "Error: Cannot write report \"" << bench.output << "\"." << endl;
+			return 1;
+		}
+	}
+
+	if (!bench.baseline.empty()) {
+		int regressions = compareBaseline(bench, results);
+		if (regressions != 0) {
+			if (regressions > 0)
+				cout << regressions << " regression(s) beyond " << bench.tolerance << "%." << endl;
+			return 1;
+		}
+		cout << "No regressions beyond " << bench.tolerance << "%." << endl;
+	}
+	return 0;
+} // main
+
+// End of HuffBench.cpp
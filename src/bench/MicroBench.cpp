@@ -0,0 +1,364 @@
+/*
+ * MicroBench.cpp
+ *
+ * Description: Microbenchmarks of the individual stages.
+ *              Each stage runs on data held in memory, over a set of
+ *              controlled histograms, so that a regression can be traced
+ *              to one stage without the noise of disk I/O.
+ *
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include "Corpus.h"
+#include "PriorityQueue.h"
+#include "HuffmanTree.h"
+#include "HuffmanTreeNode.h"
+#include "FrequencyCounter.h"
+#include "InBitStream.h"
+#include "OutBitStream.h"
+#include "BitBuffer.h"
+#include "DecodeTable.h"
+#include "EntropyCoder.h"
+#include "HeaderFormat.h"
+
+using namespace std;
+
+// Number of timed samples per benchmark, and minimum duration of a sample.
+static const unsigned NUM_OF_SAMPLES = 5;
+static const double MIN_SAMPLE_TIME = 0.05;
+
+// Desc: A histogram the stages are measured with.
+struct Histogram {
+	string name;
+	unsigned weights[256];
+}; // Histogram
+
+// Desc: Result of one benchmark.
+struct MicroResult {
+	string name;
+	unsigned long long iterations;	// Iterations per sample.
+	double seconds;					// Median time of one iteration.
+	unsigned long long bytes;		// Bytes processed per iteration, 0 if not applicable.
+}; // MicroResult
+
+// Desc: Settings of a benchmark run.
+struct MicroOptions {
+	unsigned size;			// Input size of the per-byte stages, in bytes.
+	string filter;			// Only run benchmarks whose name contains this text.
+	string output;			// Save the report to this file.
+	string dir;				// Directory for the file read by createTable.
+
+	MicroOptions() : size(4 << 20), dir("/tmp/huffbench") {}
+}; // MicroOptions
+
+// Desc: display the usage of the benchmark.
+void helpMessage() {
+	cout << "Usage:\tmicrobench [-options]" << endl;
+	cout << "Options:\t--size [KB]" << "\t\t" << "Input size of the per-byte stages (default 4096)." << endl;
+	cout << "\t\t--filter [Text]" << "\t\t" << "Only run the benchmarks whose name contains the text." << endl;
+	cout << "\t\t--dir [Dir]" << "\t\t" << "Directory for the file read by createTable (default /tmp/huffbench)." << endl;
+	cout << "\t\t--output [File]" << "\t\t" << "Save the JSON report to a file." << endl;
+}
+
+// Desc: Parse the command line.
+// Post: Return true if all options are recognized. Otherwise, return false.
+bool parseOptions(int argc, char *argv[], MicroOptions &micro) {
+	for (int i = 1; i < argc; i++) {
+		string option = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (option == "--size" && hasValue && atoi(argv[i + 1]) > 0) {
+			micro.size = (unsigned)atoi(argv[++i]) << 10;
+		} else if (option == "--filter" && hasValue) {
+			micro.filter = argv[++i];
+		} else if (option == "--dir" && hasValue) {
+			micro.dir = argv[++i];
+		} else if (option == "--output" && hasValue) {
+			micro.output = argv[++i];
+		} else {
+			cout << "Error: Unrecognized option \'" << option << "\'." << endl;
+			return false;
+		}
+	}
+	return true;
+} // parseOptions
+
+// Desc: Build the histograms:
+//       uniform   all 256 characters equally likely (flat tree, 8-bit codes);
+//       text      the histogram of the generated English-like text;
+//       skewed    geometric weights over 20 characters;
+//       fibonacci Fibonacci weights over 30 characters (deepest tree);
+//       sparse    16 characters equally likely.
+void createHistograms(vector<Histogram> &histograms) {
+	Histogram histogram;
+
+	histogram.name = "uniform";
+	for (int i = 0; i < 256; i++)
+		histogram.weights[i] = 1;
+	histograms.push_back(histogram);
+
+	histogram.name = "text";
+	vector<char> text;
+	generateCorpus("text", 1 << 20, 1, text);
+	FrequencyCounter counter;
+	counter.countBlock(text.data(), text.size());
+	copy(counter.getBitVector(), counter.getBitVector() + 256, histogram.weights);
+	histograms.push_back(histogram);
+
+	histogram.name = "skewed";
+	fill(histogram.weights, histogram.weights + 256, 0);
+	for (int i = 0; i < 20; i++)
+		histogram.weights['a' + 128 + i] = 1u << (19 - i);
+	histograms.push_back(histogram);
+
+	histogram.name = "fibonacci";
+	fill(histogram.weights, histogram.weights + 256, 0);
+	unsigned previous = 1, current = 1;
+	for (int i = 0; i < 30; i++) {
+		histogram.weights[i] = current;
+		current += previous;
+		previous = current - previous;
+	}
+	histograms.push_back(histogram);
+
+	histogram.name = "sparse";
+	fill(histogram.weights, histogram.weights + 256, 0);
+	for (int i = 0; i < 16; i++)
+		histogram.weights[i * 16] = 1;
+	histograms.push_back(histogram);
+} // createHistograms
+
+// Desc: Time "run" and append the result to "results".
+//       The iteration count is calibrated so that a sample lasts at least
+//       MIN_SAMPLE_TIME, and the median of NUM_OF_SAMPLES samples is kept.
+template <class Function>
+void measure(const MicroOptions &micro, const string &name, unsigned long long bytes, Function run, vector<MicroResult> &results) {
+	if (name.find(micro.filter) == string::npos)
+		return;
+
+	unsigned long long iterations = 1;
+	vector<double> samples;
+	while (samples.size() < NUM_OF_SAMPLES) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (unsigned long long i = 0; i < iterations; i++)
+			run();
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		if (seconds < MIN_SAMPLE_TIME && samples.empty()) {
+			iterations *= 2;
+			continue;
+		}
+		samples.push_back(seconds / iterations);
+	}
+	sort(samples.begin(), samples.end());
+
+	MicroResult result = { name, iterations, samples[NUM_OF_SAMPLES / 2], bytes };
+	results.push_back(result);
+	cerr << name << endl;
+} // measure
+
+// Desc: Decode with the original bit-by-bit walk down the Huffman tree.
+// Post: Return the number of characters decoded.
+unsigned walkTree(const HuffmanTree &tree, const char *src, unsigned srcSize, char *dst, unsigned numOfChars) {
+	HuffmanTreeNode *root = tree.getRoot();
+	HuffmanTreeNode *ptr = root;
+	unsigned count = 0;
+	for (unsigned i = 0; i < srcSize && count < numOfChars; i++) {
+		for (int bit = 7; bit >= 0 && count < numOfChars; bit--) {
+			ptr = tree.walk((src[i] >> bit) & 1, ptr);
+			if (ptr -> type == char_node) {
+				dst[count++] = ptr -> character;
+				ptr = root;
+			}
+		}
+	}
+	return count;
+} // walkTree
+
+// Desc: Run every stage over one histogram.
+void runHistogram(const MicroOptions &micro, const Histogram &histogram, vector<MicroResult> &results) {
+	string suffix = "/" + histogram.name;
+
+	// Data following the histogram, and its code tables.
+	vector<char> data;
+	generateFromHistogram(histogram.weights, micro.size, 7, data);
+	FrequencyCounter counter;
+	counter.restoreTable(histogram.weights);
+	PriorityQueue pq;
+	counter.createPriorityQueue(pq);
+	HuffmanTree tree(pq);
+	DecodeTable decodeTable(tree);
+
+	// Priority queue: enqueue every leaf, then dequeue them all.
+	vector<NodePtr> nodes;
+	for (int i = 0; i < 256; i++)
+		if (histogram.weights[i] != 0)
+			nodes.push_back(new HuffmanTreeNode(char_node, histogram.weights[i], i - 128));
+	measure(micro, "priority_queue" + suffix, 0, [&]() {
+		PriorityQueue queue;
+		for (size_t i = 0; i < nodes.size(); i++)
+			queue.enqueue(nodes[i]);
+		while (!queue.isEmpty())
+			queue.dequeue();
+	}, results);
+	for (size_t i = 0; i < nodes.size(); i++)
+		delete nodes[i];
+
+	// Huffman tree: createTree (including generateCode) from a filled queue.
+	measure(micro, "create_tree" + suffix, 0, [&]() {
+		PriorityQueue queue;
+		counter.createPriorityQueue(queue);
+		HuffmanTree huffmanTree;
+		huffmanTree.createTree(queue);
+	}, results);
+
+	measure(micro, "decode_table" + suffix, 0, [&]() {
+		DecodeTable table(tree);
+	}, results);
+
+	// Frequency counting in memory.
+	measure(micro, "count_block" + suffix, data.size(), [&]() {
+		FrequencyCounter frequency;
+		frequency.countBlock(data.data(), data.size());
+	}, results);
+
+	// Encoding: the per-byte OutBitStream path (written to /dev/null)
+	// and the BitBuffer used by the other encoders.
+	unsigned *codeTable = tree.getCodeTable();
+	unsigned *codeLengthTable = tree.getCodeLengthTable();
+	measure(micro, "load_next_byte" + suffix, data.size(), [&]() {
+		OutBitStream out;
+		out.openFile("/dev/null");
+		for (size_t i = 0; i < data.size(); i++)
+			out.loadNextByte(data[i], codeTable, codeLengthTable);
+		out.closeFile();
+	}, results);
+
+	// Code lengths stay within 32 bits for these histograms.
+	// The data is encoded once up front for the decoders below.
+	vector<char> encoded(data.size() * 4 + 8);
+	auto encode = [&]() {
+		BitBuffer buffer;
+		buffer.setDestination(encoded.data());
+		buffer.encode(data.data(), data.size(), codeTable, codeLengthTable);
+		buffer.flush();
+		return buffer.getLength();
+	};
+	unsigned encodedSize = encode();
+	measure(micro, "bit_buffer" + suffix, data.size(), encode, results);
+
+	// The same with the pair code table, built once outside the timing.
+	PairCodeTable pairs(codeTable, codeLengthTable);
+	measure(micro, "bit_buffer_pairs" + suffix, data.size(), [&]() {
+		BitBuffer buffer;
+		buffer.setDestination(encoded.data());
+		buffer.encode(data.data(), data.size(), codeTable, codeLengthTable, &pairs);
+		buffer.flush();
+	}, results);
+
+	// Decoding: the original tree walk and the lookup table.
+	vector<char> decoded(data.size());
+	measure(micro, "tree_walk" + suffix, data.size(), [&]() {
+		walkTree(tree, encoded.data(), encodedSize, decoded.data(), data.size());
+	}, results);
+	measure(micro, "decode_loop" + suffix, data.size(), [&]() {
+		const char *src = encoded.data();
+		DecodeState state;
+		decodeTable.decode(src, src + encodedSize, decoded.data(), data.size(), state);
+	}, results);
+	bool decodedAny = ("tree_walk" + suffix).find(micro.filter) != string::npos || ("decode_loop" + suffix).find(micro.filter) != string::npos;
+	if (decodedAny && decoded != data)
+		cerr << "Warning: decoding" << suffix << " does not reproduce the input." << endl;
+
+	// The coders of the blocks, side by side. They take the weights
+	// indexed by the bytes as unsigned char.
+	unsigned weights[256];
+	for (int i = 0; i < 256; i++)
+		weights[(i + 128) & 255] = histogram.weights[i];
+	const unsigned char *bytes = (const unsigned char *)data.data();
+	const char *coderNames[] = { "huffman", "tans" };
+	const char coderTypes[] = { HUFFMAN_CODER, TANS_CODER };
+	for (int c = 0; c < 2; c++) {
+		string name = string("_") + coderNames[c] + suffix;
+		EntropyCoder coder(coderTypes[c], weights, 256);
+		measure(micro, "coder_table" + name, 0, [&]() {
+			EntropyCoder table(coderTypes[c], weights, 256);
+		}, results);
+		unsigned codedSize = coder.encode(bytes, data.size(), encoded.data());
+		measure(micro, "coder_encode" + name, data.size(), [&]() {
+			coder.encode(bytes, data.size(), encoded.data());
+		}, results);
+		measure(micro, "coder_decode" + name, data.size(), [&]() {
+			coder.decode(encoded.data(), codedSize, decoded.data(), data.size());
+		}, results);
+		if (("coder_decode" + name).find(micro.filter) != string::npos && decoded != data)
+			cerr << "Warning: coder_decode" << name << " does not reproduce the input." << endl;
+	}
+} // runHistogram
+
+// Desc: Write the report as JSON, one benchmark per line.
+void writeReport(ostream &out, const vector<MicroResult> &results) {
+	char line[256];
+	out << "{\"results\": [" << endl;
+	for (size_t i = 0; i < results.size(); i++) {
+		const MicroResult &result = results[i];
+		double mbps = result.bytes > 0 ? result.bytes / result.seconds / (1 << 20) : 0;
+		snprintf(line, sizeof(line), "  {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.1f, \"mbps\": %.2f}%s",
+			result.name.c_str(), result.iterations, result.seconds * 1e9, mbps,
+			i + 1 < results.size() ? "," : "");
+		out << line << endl;
+	}
+	out << "]}" << endl;
+} // writeReport
+
+// Desc: main function
+int main(int argc, char *argv[]) {
+	MicroOptions micro;
+	if (parseOptions(argc, argv, micro) == false) {
+		helpMessage();
+		return 1;
+	}
+
+	vector<Histogram> histograms;
+	createHistograms(histograms);
+
+	vector<MicroResult> results;
+	for (size_t i = 0; i < histograms.size(); i++)
+		runHistogram(micro, histograms[i], results);
+
+	// createTable reads through InBitStream; the file is read once
+	// beforehand so that it is served from the page cache.
+	vector<char> text;
+	generateCorpus("text", micro.size, 1, text);
+	mkdir(micro.dir.c_str(), 0755);
+	string file = micro.dir + "/micro_text.dat";
+	ofstream(file.c_str(), ios::out | ios::binary).write(text.data(), text.size());
+	measure(micro, "create_table/text", text.size(), [&]() {
+		InBitStream in;
+		in.openFile(file.c_str());
+		FrequencyCounter counter;
+		counter.createTable(in);
+	}, results);
+	remove(file.c_str());
+
+	writeReport(cout, results);
+	if (!micro.output.empty()) {
+		ofstream out(micro.output.c_str());
+		writeReport(out, results);
+		if (!out.good()) {
+			cout << "Error: Cannot write report \"" << micro.output << "\"." << endl;
+			return 1;
+		}
+	}
+	return 0;
+} // main
+
+// End of MicroBench.cpp
@@ -9,33 +9,230 @@
 
 #include <iostream>
 #include <string>
-#include <ctime>
+#include <chrono>
+#include <cstdlib>
+#include "Options.h"
+#include "Stats.h"
+#include "PerfCounters.h"
+#include "Lz77.h"
+#include "Filter.h"
+#include "HuffmanBlocks.h"
+#include "HeaderFormat.h"
 
 using namespace std;
 
 // Desc: Prototypes
 //       Compression and Decompression functions.
 //       Implemented in "Compress.cpp" and "Decompress.cpp" repectively.
-int compress(const char *src, const char *dst);
-int decompress(const char *src, const char *dst);
+int compress(const char *src, const char *dst, const Options &opt);
+int decompress(const char *src, const char *dst, const Options &opt);
+
+// Desc: Decompress a list of files, sharing the code tables.
+//       Implemented in "Decompress.cpp".
+int decompressBatch(const char *listFile, const char *dstDir, const Options &opt);
+
+// Desc: Predict the compressed size without compressing.
+//       Implemented in "Estimate.cpp".
+int estimate(const char *src, const Options &opt);
+
+// Desc: Train a static table from a sample corpus.
+//       Implemented in "StaticTable.cpp".
+int trainTable(const char *corpus, const char *tableFile);
 
 // Desc: display the usage of the program.
 void helpMessage() {
 	cout << "Usage:\t" << "[-options] [Source] [Destination]" << endl;
 	cout << "Options:\t-c, --compress" << "\t\t" << "Compress the input file and write the compressed data to the destination file." << endl;
 	cout << "\t\t-d, --decompress" << "\t" << "Decompress the input file and write the decompressed data to the destination file." << endl;
+	cout << "\t\t-t, --train" << "\t\t" << "Train a static table from the input file (sample corpus) and write it to the destination file." << endl;
+	cout << "\t\t-e, --estimate" << "\t\t" << "Predict the compressed size of the input file without writing anything (no destination)." << endl;
 	cout << "\t\t-h, --help" << "\t\t" << "Display this information." << endl;
+	cout << "Extra options (after -c, -d or -e):" << endl;
+	cout << "\t\t--table [Table]" << "\t\t" << "Use a static table trained with -t instead of storing the frequency table." << endl;
+	cout << "\t\t--pipeline" << "\t\t" << "Overlap reading, coding and writing using background I/O threads." << endl;
+	cout << "\t\t-j, --threads [N]" << "\t" << "Encode / decode with N threads (1 to 256). The output is identical to the single-threaded one." << endl;
+	cout << "\t\t--append" << "\t\t" << "(-c only) Add the input file to the end of an existing compressed file." << endl;
+	cout << "\t\t--lz77 [W]" << "\t\t" << "(-c only) Replace strings repeated within the last W KB (1 to 16384) before Huffman coding." << endl;
+	cout << "\t\t--bwt" << "\t\t\t" << "(-c only) Sort 1 MB blocks with the Burrows-Wheeler transform before Huffman coding." << endl;
+	cout << "\t\t--rle" << "\t\t\t" << "(-c only) Code runs of a repeated byte with one symbol each." << endl;
+	cout << "\t\t--symbols [B]" << "\t\t" << "(-c only) Huffman code B-bit symbols: 8 (bytes) or 16 (e.g. UTF-16 text, token IDs)." << endl;
+	cout << "\t\t--frame [K]" << "\t\t" << "(-c only) Code each byte position within frames of K bytes (1 to 32, or auto) with its own tree." << endl;
+	cout << "\t\t--coder [C]" << "\t\t" << "(-c only) Entropy coder of each 1 MB block: huffman, tans or auto." << endl;
+	cout << "\t\t--filter [F]" << "\t\t" << "(-c only) Filter arrays of values before coding: auto, split, delta or xor." << endl;
+	cout << "\t\t--stride [S]" << "\t\t" << "(-c only) Size of the values of --filter in bytes (1 to 16). Detected by default." << endl;
+	cout << "\t\t--batch" << "\t\t\t" << "(-d only) Source is a list of compressed files, destination is the output directory." << endl;
+	cout << "\t\t--sample [P]" << "\t\t" << "(-e only) Count P percent of the input file instead of all of it." << endl;
+	cout << "\t\t--stats" << "\t\t\t" << "Report the time, bytes and throughput of each stage, and the code statistics." << endl;
+	cout << "\t\t--profile" << "\t\t" << "Like --stats, plus cycles, IPC, branch and cache misses of each stage (Linux perf events)." << endl;
 }
 
+// Desc: Parse the extra options between the mode option and the file
+//       names, which start at argv[end].
+// Post: Return true if all of them are recognized. Otherwise, return false.
+bool parseOptions(int end, char *argv[], Options &opt) {
+	for (int i = 2; i < end; i++) {
+		string option = argv[i];
+		if (option == "--table" && i + 1 < end) {
+			opt.tableFile = argv[++i];
+		} else if (option == "--pipeline") {
+			opt.pipeline = true;
+		} else if ((option == "-j" || option == "--threads") && i + 1 < end) {
+			int numOfThreads = atoi(argv[++i]);
+			if (numOfThreads < 1 || numOfThreads > (int)MAX_THREADS) {
+				cout << "Error: Invalid number of threads \'" << argv[i] << "\'." << endl;
+				return false;
+			}
+			opt.numOfThreads = numOfThreads;
+		} else if (option == "--append") {
+			opt.append = true;
+		} else if (option == "--lz77" && i + 1 < end) {
+			int window = atoi(argv[++i]);
+			if (window < 1 || window > (int)(MAX_LZ77_WINDOW >> 10)) {
+				cout << "Error: Invalid window size \'" << argv[i] << "\'." << endl;
+				return false;
+			}
+			// Rounded up to a power of two.
+			opt.lzWindow = MIN_LZ77_WINDOW;
+			while (opt.lzWindow < (unsigned)window << 10)
+				opt.lzWindow <<= 1;
+		} else if (option == "--bwt") {
+			opt.bwt = true;
+		} else if (option == "--rle") {
+			opt.runs = true;
+		} else if (option == "--symbols" && i + 1 < end) {
+			int bits = atoi(argv[++i]);
+			if (bits != 8 && bits != 16) {
+				cout << "Error: Invalid symbol size \'" << argv[i] << "\'." << endl;
+				return false;
+			}
+			opt.symbolBits = bits;
+		} else if (option == "--frame" && i + 1 < end) {
+			string size = argv[++i];
+			int frameSize = size == "auto" ? 0 : atoi(size.c_str());
+			if (size != "auto" && (frameSize < 1 || frameSize > (int)MAX_FRAME_SIZE)) {
+				cout << "Error: Invalid frame size \'" << size << "\'." << endl;
+				return false;
+			}
+			opt.frames = true;
+			opt.frameSize = frameSize;
+		} else if (option == "--coder" && i + 1 < end) {
+			string name = argv[++i];
+			if (name == "huffman") {
+				opt.coder = HUFFMAN_CODER;
+			} else if (name == "tans") {
+				opt.coder = TANS_CODER;
+			} else if (name == "auto") {
+				opt.coder = AUTO_CODER;
+			} else {
+				cout << "Error: Invalid coder \'" << name << "\'." << endl;
+				return false;
+			}
+		} else if (option == "--filter" && i + 1 < end) {
+			string name = argv[++i];
+			if (name == "auto") {
+				opt.filter = AUTO_FILTER;
+			} else if (name == "split") {
+				opt.filter = SPLIT_FILTER;
+			} else if (name == "delta") {
+				opt.filter = DELTA_FILTER;
+			} else if (name == "xor") {
+				opt.filter = XOR_FILTER;
+			} else {
+				cout << "Error: Invalid filter \'" << name << "\'." << endl;
+				return false;
+			}
+		} else if (option == "--stride" && i + 1 < end) {
+			int stride = atoi(argv[++i]);
+			if (stride < 1 || stride > (int)MAX_FILTER_STRIDE) {
+				cout << "Error: Invalid stride \'" << argv[i] << "\'." << endl;
+				return false;
+			}
+			opt.filterStride = stride;
+		} else if (option == "--batch") {
+			opt.batch = true;
+		} else if (option == "--sample" && i + 1 < end) {
+			int percent = atoi(argv[++i]);
+			if (percent < 1 || percent > 100) {
+				cout << "Error: Invalid sample percentage \'" << argv[i] << "\'." << endl;
+				return false;
+			}
+			opt.samplePercent = percent;
+		} else if (option == "--stats" || option == "--profile") {
+			static Stats stats;
+			opt.stats = &stats;
+			if (option == "--profile") {
+				static PerfCounters perf;
+				stats.perf = &perf;
+			}
+		} else {
+			cout << "Error: Unrecognized option \'" << option << "\'." << endl;
+			return false;
+		}
+	}
+	if (opt.bwt && opt.lzWindow != 0) {
+		cout << "Error: --lz77 and --bwt cannot be combined." << endl;
+		return false;
+	}
+	if (opt.runs && (opt.bwt || opt.lzWindow != 0)) {
+		cout << "Error: --rle cannot be combined with --lz77 or --bwt, which code runs already." << endl;
+		return false;
+	}
+	if (opt.symbolBits != 8 && (opt.runs || opt.bwt || opt.lzWindow != 0)) {
+		cout << "Error: --symbols 16 cannot be combined with --rle, --lz77 or --bwt." << endl;
+		return false;
+	}
+	if (opt.frames && (opt.runs || opt.bwt || opt.lzWindow != 0 || opt.symbolBits != 8)) {
+		cout << "Error: --frame cannot be combined with --rle, --lz77, --bwt or --symbols." << endl;
+		return false;
+	}
+	if (opt.frames && opt.filter != NO_FILTER) {
+		cout << "Error: --frame cannot be combined with --filter, which splits the values into planes already." << endl;
+		return false;
+	}
+	if (opt.coder != HUFFMAN_CODER && (opt.runs || opt.bwt || opt.lzWindow != 0 || opt.symbolBits != 8 || opt.frames)) {
+		cout << "Error: --coder cannot be combined with --rle, --lz77, --bwt, --symbols or --frame." << endl;
+		return false;
+	}
+	if (opt.filterStride != 0 && opt.filter == NO_FILTER) {
+		cout << "Error: --stride requires --filter." << endl;
+		return false;
+	}
+	if (opt.tableFile != NULL && (opt.lzWindow != 0 || opt.bwt || opt.runs || opt.symbolBits != 8 || opt.frames ||
+		opt.coder != HUFFMAN_CODER || opt.filter != NO_FILTER)) {
+		cout << "Error: --table cannot be combined with --lz77, --bwt, --rle, --symbols, --frame, --coder or --filter, "
+			<< "which store their own tables." << endl;
+		return false;
+	}
+	return true;
+} // parseOptions
+
 // Desc: main function
 int main(int argc, char *argv[]) {
 
-	if (argc == 2) {
+	if (argc >= 3 && (string(argv[1]) == "-e" || string(argv[1]) == "--estimate")) {
+		// Estimation takes no destination file.
+		Options opt;
+		if (parseOptions(argc - 1, argv, opt) == false) {
+			helpMessage();
+			return 1;
+		}
+
+		// The estimate is the size of the plain Huffman code, which
+		// tells nothing about the other methods.
+		if (opt.lzWindow != 0 || opt.bwt || opt.runs || opt.symbolBits != 8 || opt.frames ||
+			opt.coder != HUFFMAN_CODER || opt.filter != NO_FILTER) {
+			cout << "Error: -e cannot be combined with --lz77, --bwt, --rle, --symbols, --frame, --coder or --filter." << endl;
+			helpMessage();
+			return 1;
+		}
+		return estimate(argv[argc - 1], opt) == -1 ? -1 : 0;
+	} else if (argc == 2) {
 		string option = argv[1];
 		if (option == "-h" || option == "--help") {
 			helpMessage();
 			return 0;
-		} else if (option == "-c" || option == "-d" || option == "--compress" || option == "--decompress") {
+		} else if (option == "-c" || option == "-d" || option == "-t" || option == "-e" ||
+			option == "--compress" || option == "--decompress" || option == "--train" || option == "--estimate") {
 			cout << "Error: Invalid number of arguments." << endl;
 			helpMessage();
 			return 1;
@@ -44,39 +241,46 @@ int main(int argc, char *argv[]) {
 			helpMessage();
 			return 1;
 		}
-	} else if (argc == 4) {
+	} else if (argc >= 4) {
 		string option = argv[1];
-		string src = argv[2];
-		string dst = argv[3];
+		string src = argv[argc - 2];
+		string dst = argv[argc - 1];
+
+		Options opt;
+		if (parseOptions(argc - 2, argv, opt) == false) {
+			helpMessage();
+			return 1;
+		}
+
+		if (src == dst) {
+			cout << "Error: Source and destination file names are the same." << endl;
+			return 1;
+		}
 
 		if (option == "-c" || option == "--compress") {		// Compression
-			if (src != dst){
-				clock_t start = clock();
-				int status = compress(argv[2], argv[3]);
-				if (status == -1) {
-					return -1;
-				} else {
-					cout << "Compression completed in " << (clock() - start) / (double)(CLOCKS_PER_SEC) << " seconds." << endl;
-					return 0;
-				}
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			int status = compress(src.c_str(), dst.c_str(), opt);
+			if (status == -1) {
+				return -1;
 			} else {
-				cout << "Error: Source and destination file names are the same." << endl;
-				return 1;
+				cout << "Compression completed in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " seconds." << endl;
+				if (opt.stats != NULL)
+					opt.stats -> print(cout);
+				return 0;
 			}
 		} else if (option == "-d" || option == "--decompress") {	// Decompression
-			if (src != dst){
-				clock_t start = clock();
-				int status = decompress(argv[2], argv[3]);
-				if (status == -1) {
-					return -1;
-				} else {
-					cout << "Decompression completed in " << (clock() - start) / (double)(CLOCKS_PER_SEC) << " seconds." << endl;
-					return 0;
-				}
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			int status = opt.batch ? decompressBatch(src.c_str(), dst.c_str(), opt) : decompress(src.c_str(), dst.c_str(), opt);
+			if (status == -1) {
+				return -1;
 			} else {
-				cout << "Error: Source and destination file names are the same." << endl;
-				return 1;
+				cout << "Decompression completed in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " seconds." << endl;
+				if (opt.stats != NULL)
+					opt.stats -> print(cout);
+				return 0;
 			}
+		} else if ((option == "-t" || option == "--train") && argc == 4) {	// Training
+			return trainTable(src.c_str(), dst.c_str()) == -1 ? -1 : 0;
 		} else {
 			cout << "Error: Unrecognized option \'" << option << "\'." << endl;
 			helpMessage();